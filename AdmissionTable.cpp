@@ -0,0 +1,86 @@
+#ifndef __ADMISSION_TABLE_CPP__
+#define __ADMISSION_TABLE_CPP__
+
+#include "AdmissionTable.h"
+
+using namespace std;
+
+/*
+ * Fills the light states and the admission entries for every position of the light cycle
+ * @param const SimConfig& config
+ */
+AdmissionTable::AdmissionTable(const SimConfig& config)
+        : lightCycle(config.getLightCycle()), types(config.vehicleClasses.size()) {
+    lights.resize(lightCycle);
+    admitted.resize(lightCycle * AXES * types * TURNS);
+
+    Direction axes[AXES] = {Direction::north, Direction::east};
+    TurnType turns[TURNS] = {TurnType::straight, TurnType::right, TurnType::left};
+
+    for (int cyclePosition = 0; cyclePosition < lightCycle; cyclePosition++) {
+        LightState state = lightsAt(config, cyclePosition);
+        lights[cyclePosition] = state;
+
+        for (Direction direction : axes) {
+            // The light of the vehicle's lane can't be red
+            bool northSouth = (direction == Direction::north);
+            LightColor color = northSouth ? state.northSouth : state.eastWest;
+            int timeToRed = northSouth ? state.NSTimeToRed : state.EWTimeToRed;
+
+            for (int k = 0; k < types; k++) {
+                VehicleType type = static_cast<VehicleType>(k);
+                for (TurnType turn : turns) {
+                    // Enough time before red-light for full transition
+                    int checkLength = config.vehicleClasses[k].length;
+                    if (turn == TurnType::right) {
+                        checkLength--;
+                    }
+                    admitted[entryIndex(cyclePosition, direction, type, turn)] =
+                        (color != LightColor::red) && (timeToRed > checkLength);
+                }
+            }
+        }
+    }
+}
+
+/* Finds the color of light in each bound and calculates the time to be red for each light
+ * @param const SimConfig& config light durations
+ * @param int cyclePosition time modulo the length of the light cycle
+ * @return LightState
+ */
+LightState AdmissionTable::lightsAt(const SimConfig& config, int cyclePosition) {
+    int greenNS = config.greenNS;
+    int yellowNS = config.yellowNS;
+    int greenEW = config.greenEW;
+    int yellowEW = config.yellowEW;
+
+    LightState state;
+
+    // Light for North South
+    if (cyclePosition < greenNS) {
+        state.northSouth = LightColor::green;
+        state.NSTimeToRed = yellowNS + (greenNS - cyclePosition);
+    } else if (cyclePosition < greenNS + yellowNS) {
+        state.northSouth = LightColor::yellow;
+        state.NSTimeToRed = greenNS + yellowNS - cyclePosition;
+    } else {
+        state.northSouth = LightColor::red;
+        state.NSTimeToRed = 0;
+    }
+
+    // Light for East West
+    if (cyclePosition < greenNS + yellowNS) {
+        state.eastWest = LightColor::red;
+        state.EWTimeToRed = 0;
+    } else if (cyclePosition < greenNS + yellowNS + greenEW) {
+        state.eastWest = LightColor::green;
+        state.EWTimeToRed = (greenNS + yellowNS + greenEW + yellowEW) - cyclePosition;
+    } else {
+        state.eastWest = LightColor::yellow;
+        state.EWTimeToRed = config.getLightCycle() - cyclePosition;
+    }
+
+    return state;
+}
+
+#endif
@@ -0,0 +1,57 @@
+#ifndef __ADMISSION_TABLE_H__
+#define __ADMISSION_TABLE_H__
+
+#include <vector>
+#include <cstdint>
+#include "SimConfig.h"
+#include "Vehicle.h"
+#include "VehicleBase.h"
+
+using namespace std;
+
+// Colors of both lights and the time left before each turns red
+struct LightState {
+    LightColor northSouth;
+    int NSTimeToRed;
+    LightColor eastWest;
+    int EWTimeToRed;
+};
+
+/*
+ * Stop-line decisions precomputed for one light cycle. Whether a vehicle at
+ * the stop line may enter the intersection (light not red and enough time to
+ * finish the transition before red) only depends on the position in the light
+ * cycle, the vehicle's original direction, its class and its turn, so it is
+ * computed once per configuration. The table is immutable after construction
+ * and can be shared by any number of Simulator instances.
+ */
+class AdmissionTable {
+    private:
+        static const int AXES = 2;
+        static const int TURNS = 3;
+
+        int lightCycle;
+        int types;          // vehicle classes of the configuration
+        vector<LightState> lights;
+        vector<uint8_t> admitted;
+
+        inline int entryIndex(int cyclePosition, Direction direction, VehicleType type, TurnType turn) const {
+            int axis = (direction == Direction::north || direction == Direction::south) ? 0 : 1;
+            return ((cyclePosition * AXES + axis) * types + static_cast<int>(type)) * TURNS + static_cast<int>(turn);
+        }
+
+    public:
+        AdmissionTable(const SimConfig& config);
+
+        static LightState lightsAt(const SimConfig& config, int cyclePosition);
+
+        inline int getLightCycle() const { return lightCycle; }
+        inline const LightState& getLights(int cyclePosition) const { return lights[cyclePosition]; }
+
+        inline bool admits(int cyclePosition, Vehicle& vehicle) const {
+            return admitted[entryIndex(cyclePosition, vehicle.getVehicleOriginalDirection(),
+                                       vehicle.getVehicleType(), vehicle.getTurn())];
+        }
+};
+
+#endif
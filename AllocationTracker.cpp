@@ -0,0 +1,73 @@
+#ifndef __ALLOCATION_TRACKER_CPP__
+#define __ALLOCATION_TRACKER_CPP__
+
+#include "AllocationTracker.h"
+
+#include <cstring>
+
+using namespace std;
+
+AllocationCount AllocationTracker::sites[AllocationTracker::MAX_SITES];
+int AllocationTracker::siteCount = 0;
+long AllocationTracker::total = 0;
+thread_local bool AllocationTracker::tracking = false;
+thread_local const char* AllocationTracker::currentSite = nullptr;
+
+// Set by CountingNew.o when it is linked in
+bool allocationCountingLinked __attribute__((weak)) = false;
+
+/*
+ * Starts counting the allocations made by the calling thread
+ */
+void AllocationTracker::start() {
+    tracking = true;
+}
+
+void AllocationTracker::stop() {
+    tracking = false;
+}
+
+/*
+ * Forgets the counts (the sites stay registered)
+ */
+void AllocationTracker::clear() {
+    for (int i = 0; i < siteCount; i++) {
+        sites[i].count = 0;
+        sites[i].bytes = 0;
+    }
+    total = 0;
+}
+
+/*
+ * Charges one allocation to the current site; must not allocate itself
+ * @param size_t bytes
+ */
+void AllocationTracker::record(size_t bytes) {
+    if (!tracking) {
+        return;
+    }
+    const char* site = currentSite ? currentSite : "(unmarked)";
+    total++;
+
+    int i = 0;
+    while (i < siteCount && sites[i].site != site && strcmp(sites[i].site, site) != 0) {
+        i++;
+    }
+    if (i == siteCount) {
+        if (siteCount == MAX_SITES) {
+            return;
+        }
+        sites[siteCount++] = AllocationCount{site, 0, 0};
+    }
+    sites[i].count++;
+    sites[i].bytes += bytes;
+}
+
+/*
+ * @return bool true if the program replaces operator new with the counting one
+ */
+bool AllocationTracker::isLinked() {
+    return allocationCountingLinked;
+}
+
+#endif
@@ -0,0 +1,59 @@
+#ifndef __ALLOCATION_TRACKER_H__
+#define __ALLOCATION_TRACKER_H__
+
+#include <cstddef>
+
+using namespace std;
+
+// Heap allocations charged to one call site
+struct AllocationCount {
+    const char* site;
+    long count;
+    long bytes;
+};
+
+/*
+ * Counts heap allocations by call site. Code marks the site it is running
+ * with an AllocationSite; the counts are only collected when the program is
+ * linked with CountingNew.o (which replaces the global operator new) and only
+ * on the thread that called start(). Marking a site costs one thread-local
+ * store, so the marks stay in the simulation code.
+ */
+class AllocationTracker {
+    public:
+        static const int MAX_SITES = 64;
+
+    private:
+        static AllocationCount sites[MAX_SITES];
+        static int siteCount;
+        static long total;
+        static thread_local bool tracking;
+        static thread_local const char* currentSite;
+
+        friend class AllocationSite;
+
+    public:
+        static void start();
+        static void stop();
+        static void clear();
+        static void record(size_t bytes);
+
+        static bool isLinked();
+        inline static long getTotal() { return total; }
+        inline static int getSiteCount() { return siteCount; }
+        inline static const AllocationCount& getSite(int i) { return sites[i]; }
+};
+
+// Names the code running until the end of the scope (sites nest)
+class AllocationSite {
+    private:
+        const char* previous;
+
+    public:
+        inline AllocationSite(const char* site) : previous(AllocationTracker::currentSite) {
+            AllocationTracker::currentSite = site;
+        }
+        inline ~AllocationSite() { AllocationTracker::currentSite = previous; }
+};
+
+#endif
@@ -1,9 +1,11 @@
 #ifndef __ANIMATOR_CPP__
 #define __ANIMATOR_CPP__
 
+#include <algorithm>
 #include <cmath>
 #include <iomanip>
 #include <iostream>
+#include <sstream>
 #include <stdexcept>
 #include "Animator.h"
 
@@ -12,46 +14,71 @@ int Animator::MAX_VEHICLE_COUNT = 9999;
 
 // computed in constructor since user can redefine count above
 int Animator::DIGITS_TO_DRAW = 0;
+// 10^DIGITS_TO_DRAW: larger vehicle IDs are drawn as '*' and their last digits
+int Animator::ID_MODULUS = 0;
 // repeated strings of '-' or ' ' based on the digit-width MAX_VEHCILE_COUNT;
 // both computed in constructor
 std::string Animator::SECTION_BOUNDARY_EW = "";
 std::string Animator::EMPTY_SECTION = "";
 
 // see https://unix.stackexchange.com/questions/124407/what-color-codes-can-i-use-in-my-ps1-prompt
-const std::string Animator::COLOR_RED_FG    = "\033[1;31m";
-const std::string Animator::COLOR_GREEN_FG  = "\033[1;32m";
-const std::string Animator::COLOR_BLUE_FG   = "\033[1;34m";
-const std::string Animator::COLOR_RED_BG    = "\033[41m\033[1;37m";
-const std::string Animator::COLOR_GREEN_BG  = "\033[42m\033[1;37m";
-const std::string Animator::COLOR_BLUE_BG   = "\033[44m\033[1;37m";
-const std::string Animator::COLOR_YELLOW_BG = "\033[43m\033[1;37m";
-const std::string Animator::COLOR_RESET     = "\033[0m";
+const std::string Animator::COLOR_RED_FG     = "\033[1;31m";
+const std::string Animator::COLOR_GREEN_FG   = "\033[1;32m";
+const std::string Animator::COLOR_BLUE_FG    = "\033[1;34m";
+const std::string Animator::COLOR_RED_BG     = "\033[41m\033[1;37m";
+const std::string Animator::COLOR_GREEN_BG   = "\033[42m\033[1;37m";
+const std::string Animator::COLOR_BLUE_BG    = "\033[44m\033[1;37m";
+const std::string Animator::COLOR_YELLOW_BG  = "\033[43m\033[1;37m";
+const std::string Animator::COLOR_MAGENTA_FG = "\033[1;35m";
+const std::string Animator::COLOR_MAGENTA_BG = "\033[45m\033[1;37m";
+const std::string Animator::COLOR_RESET      = "\033[0m";
 
 std::string Animator::GREEN_LIGHT = "";
 std::string Animator::YELLOW_LIGHT = "";
 std::string Animator::RED_LIGHT = "";
 
 const std::string Animator::SECTION_BOUNDARY_NS = "|";
+const std::string Animator::DENSITY_LEVELS = " .:;=+*#%@";
 const std::string Animator::ERROR_MSG =
     "Error in Animator::draw: must call all four Animator::setVehicles* methods prior to calling Animator::draw";
 
 //======================================================================
-//* Animator::Animator(int numSectionsBeforeIntersection)
+//* Animator::Animator(int numSectionsBeforeIntersection,
+//*                    int viewportSections, int densityBlocks)
 //======================================================================
-Animator::Animator(int numSectionsBeforeIntersection)
+Animator::Animator(int numSectionsBeforeIntersection, int viewportSections,
+                   int densityBlocks)
 {
     // redo here in case the user set MAX_VEHCILE_COUNT differently
     Animator::DIGITS_TO_DRAW = Animator::MAX_VEHICLE_COUNT <= 1 ? 
         2 : static_cast<int>(log10(Animator::MAX_VEHICLE_COUNT)) + 1;
     Animator::SECTION_BOUNDARY_EW = std::string(Animator::DIGITS_TO_DRAW, '-');
     Animator::EMPTY_SECTION = std::string(Animator::DIGITS_TO_DRAW, ' ');
+    Animator::ID_MODULUS = static_cast<int>(pow(10, Animator::DIGITS_TO_DRAW));
 
     // these will use the redone DIGITS TO DRAW above
     Animator::GREEN_LIGHT  = createLight(LightColor::green);
     Animator::YELLOW_LIGHT = createLight(LightColor::yellow);
     Animator::RED_LIGHT    = createLight(LightColor::red);
 
-    numSectionsBefore = numSectionsBeforeIntersection;
+    roadSectionsBefore = numSectionsBeforeIntersection;
+
+    // the whole road is drawn unless the viewport is shorter than the road;
+    // the hidden sections are split into at most densityBlocks blocks
+    int hidden = roadSectionsBefore - viewportSections;
+    if (viewportSections <= 0 || hidden <= 0)
+    {
+        this->viewportSections = roadSectionsBefore;
+        this->densityBlocks = 0;
+        blockSize = 1;
+    }
+    else
+    {
+        this->viewportSections = viewportSections;
+        blockSize = (hidden + std::max(1, densityBlocks) - 1) / std::max(1, densityBlocks);
+        this->densityBlocks = (hidden + blockSize - 1) / blockSize;
+    }
+    numSectionsBefore = this->viewportSections + this->densityBlocks;
 
     // each lane will be twice the number of sections provided (before and 
     // after the intersection) plus the two intersection sections
@@ -59,6 +86,11 @@ Animator::Animator(int numSectionsBeforeIntersection)
     westToEast.resize(numSectionsBefore * 2 + 2);
     northToSouth.resize(numSectionsBefore * 2 + 2);
     southToNorth.resize(numSectionsBefore * 2 + 2);
+    eastToWestDensity.assign(numSectionsBefore * 2 + 2, -1);
+    westToEastDensity.assign(numSectionsBefore * 2 + 2, -1);
+    northToSouthDensity.assign(numSectionsBefore * 2 + 2, -1);
+    southToNorthDensity.assign(numSectionsBefore * 2 + 2, -1);
+    blockCounts.resize(this->densityBlocks);
 
     // this will set the values in the vector to 0 (false), indicating that
     // the user must set the vehicles in each of the four directions using the
@@ -71,6 +103,41 @@ Animator::Animator(int numSectionsBeforeIntersection)
 //======================================================================
 Animator::~Animator() {}
 
+//======================================================================
+//* void Animator::setLane(std::vector<VehicleBase*>& cells,
+//*                        std::vector<int>& density, const LaneView& lane)
+//======================================================================
+void Animator::setLane(std::vector<VehicleBase*>& cells,
+                       std::vector<int>& density, const LaneView& lane)
+{
+    if (lane.size() != roadSectionsBefore * 2 + 2)
+        throw std::runtime_error("Error in Animator::setVehicles*: the lane doesn't "
+                                 "match the number of sections given to the constructor");
+
+    // the sections next to the intersection are copied as they are
+    int hidden = roadSectionsBefore - viewportSections;
+    lane.copyRange(hidden, roadSectionsBefore * 2 + 1 - hidden,
+                   cells.data() + densityBlocks);
+    if (densityBlocks == 0) return;
+
+    // the far end of the approach, then the far end of the departure
+    int departureBlocks = densityBlocks + viewportSections * 2 + 2;
+    lane.countOccupied(0, hidden - 1, blockSize, blockCounts.data());
+    for (int b = 0; b < densityBlocks; b++)
+    {
+        int sections = std::min(blockSize, hidden - b * blockSize);
+        density[b] = blockCounts[b] == 0 ? 0 : 1 + (blockCounts[b] * 8) / sections;
+    }
+    lane.countOccupied(roadSectionsBefore * 2 + 2 - hidden, roadSectionsBefore * 2 + 1,
+                       blockSize, blockCounts.data());
+    for (int b = 0; b < densityBlocks; b++)
+    {
+        int sections = std::min(blockSize, hidden - b * blockSize);
+        density[departureBlocks + b] =
+            blockCounts[b] == 0 ? 0 : 1 + (blockCounts[b] * 8) / sections;
+    }
+}
+
 //======================================================================
 //* std::string Animator::createLight(LightColor color)
 //======================================================================
@@ -91,13 +158,22 @@ std::string Animator::createLight(LightColor color)
 //* Animator::draw(int time)
 //======================================================================
 void Animator::draw(int time)
+{
+    std::cout << render(time) << std::flush;
+}
+
+//======================================================================
+//* std::string Animator::render(int time)
+//======================================================================
+std::string Animator::render(int time)
 {
     // ensure all four setVehicles* methods have been called prior
     std::vector<bool>::iterator it = vehiclesAreSet.begin();
     for (; it != vehiclesAreSet.end(); it++)
         if (*it == false) throw std::runtime_error(Animator::ERROR_MSG.c_str());
 
-    std::cout << "\x1B[2J\x1B[H";  // clears the screen
+    frame.str("");
+    frame << "\x1B[2J\x1B[H";  // clears the screen
 
     drawNorthPortion(time);
     drawWestbound();
@@ -109,6 +185,8 @@ void Animator::draw(int time)
     // setVehicles* functions
     vehiclesAreSet.clear();
     vehiclesAreSet.resize(4);
+
+    return frame.str();
 }
 
 //======================================================================
@@ -131,8 +209,12 @@ std::string Animator::getVehicleColor(VehicleBase* vptr)
             if (dir == Direction::east || dir == Direction::west)
                 return Animator::COLOR_GREEN_BG;
             return Animator::COLOR_GREEN_FG;
+        default:
+            // vehicle classes of the input file
+            if (dir == Direction::east || dir == Direction::west)
+                return Animator::COLOR_MAGENTA_BG;
+            return Animator::COLOR_MAGENTA_FG;
     }
-    return Animator::COLOR_RESET;
 }
 
 //======================================================================
@@ -174,6 +256,39 @@ std::string Animator::getTrafficLight(Direction direction)
     return light;
 }
 
+//======================================================================
+//* Animator::drawSection(VehicleBase* vptr, int density)
+//======================================================================
+void Animator::drawSection(VehicleBase* vptr, int density)
+{
+    if (density >= 0)
+        frame << std::string(Animator::DIGITS_TO_DRAW,
+                             Animator::DENSITY_LEVELS[density]);
+    else if (vptr == nullptr)
+        frame << Animator::EMPTY_SECTION;
+    else if (vptr->getVehicleID() < Animator::ID_MODULUS)
+        frame << getVehicleColor(vptr)
+                  << std::setfill('0') << std::setw(Animator::DIGITS_TO_DRAW)
+                  << vptr->getVehicleID()
+                  << Animator::COLOR_RESET;
+    else
+        // a '*' in front tells a truncated ID from a whole one
+        frame << getVehicleColor(vptr) << '*'
+                  << std::setfill('0') << std::setw(Animator::DIGITS_TO_DRAW - 1)
+                  << vptr->getVehicleID() % (Animator::ID_MODULUS / 10)
+                  << Animator::COLOR_RESET;
+}
+
+//======================================================================
+//* Animator::drawSection(const std::vector<VehicleBase*>& cells,
+//*                       const std::vector<int>& density, int section)
+//======================================================================
+void Animator::drawSection(const std::vector<VehicleBase*>& cells,
+                           const std::vector<int>& density, int section)
+{
+    drawSection(cells[section], density[section]);
+}
+
 //======================================================================
 //* Animator::drawNorthPortion(int time)
 //======================================================================
@@ -184,60 +299,48 @@ void Animator::drawNorthPortion(int time)
         // draw empty spaces to account for E/W lanes to left of intersection
         for (int i = 0; i < numSectionsBefore; i++) 
             if (s == numSectionsBefore - 1 && i == s)
-                std::cout << (i > 0 ? " " : "") 
+                frame << (i > 0 ? " " : "") 
                           << getTrafficLight(Direction::south); // or north
             else
-                std::cout << (i > 0 ? " " : "") << Animator::EMPTY_SECTION;
+                frame << (i > 0 ? " " : "") << Animator::EMPTY_SECTION;
 
-        std::cout << Animator::SECTION_BOUNDARY_NS;
+        frame << Animator::SECTION_BOUNDARY_NS;
 
         // either draw (a portion of) southbound vehicle if present, 
         // or an empty section
-        if (northToSouth[s] == nullptr)
-            std::cout << Animator::EMPTY_SECTION;
-        else
-            std::cout << getVehicleColor(northToSouth[s])
-                      << std::setfill('0') << std::setw(Animator::DIGITS_TO_DRAW)
-                      << northToSouth[s]->getVehicleID()
-                      << Animator::COLOR_RESET;
+        drawSection(northToSouth, northToSouthDensity, s);
 
-        std::cout << Animator::SECTION_BOUNDARY_NS;
+        frame << Animator::SECTION_BOUNDARY_NS;
 
         // either draw (a portion of) northbound vehicle if present, 
         // or an empty section
         int section = southToNorth.size() - s - 1;
-        if (southToNorth[section] == nullptr)
-            std::cout << Animator::EMPTY_SECTION;
-        else
-            std::cout << getVehicleColor(southToNorth[section])
-                      << std::setfill('0') << std::setw(Animator::DIGITS_TO_DRAW)
-                      << southToNorth[section]->getVehicleID()
-                      << Animator::COLOR_RESET;
+        drawSection(southToNorth, southToNorthDensity, section);
 
-        std::cout << Animator::SECTION_BOUNDARY_NS;
+        frame << Animator::SECTION_BOUNDARY_NS;
 
         if (s == numSectionsBefore - 1)
-            std::cout << getTrafficLight(Direction::west);  // or east
+            frame << getTrafficLight(Direction::west);  // or east
 
-        std::cout << std::endl;
+        frame << std::endl;
 
         if (s < numSectionsBefore - 1)  // last will be drawn by westbound method
         {
             // draw empty spaces to account for E/W lanes to left of intersection
             for (int i = 0; i < numSectionsBefore; i++) 
-                std::cout << (i > 0 ? " " : "") << Animator::EMPTY_SECTION;
-            std::cout << Animator::SECTION_BOUNDARY_NS << Animator::SECTION_BOUNDARY_EW
+                frame << (i > 0 ? " " : "") << Animator::EMPTY_SECTION;
+            frame << Animator::SECTION_BOUNDARY_NS << Animator::SECTION_BOUNDARY_EW
                       << Animator::SECTION_BOUNDARY_NS << Animator::SECTION_BOUNDARY_EW 
                       << Animator::SECTION_BOUNDARY_NS;
         }
 
         // draw the time halfway down, on right
         if (s == numSectionsBefore / 2) 
-            std::cout << std::setfill(' ') 
+            frame << std::setfill(' ') 
                 << std::setw((numSectionsBefore / 2) * Animator::DIGITS_TO_DRAW)
                 << "time: " << time;
 
-        if (s < numSectionsBefore - 1) std::cout << std::endl;
+        if (s < numSectionsBefore - 1) frame << std::endl;
     }
 }
 
@@ -247,13 +350,13 @@ void Animator::drawNorthPortion(int time)
 void Animator::drawEastWestBoundary()
 {
     for (int s = 0; s < numSectionsBefore; s++)
-        std::cout << Animator::SECTION_BOUNDARY_EW 
+        frame << Animator::SECTION_BOUNDARY_EW 
             << (s == numSectionsBefore-1 ? Animator::SECTION_BOUNDARY_NS : " ");
-    std::cout << Animator::SECTION_BOUNDARY_EW << Animator::SECTION_BOUNDARY_NS;
-    std::cout << Animator::SECTION_BOUNDARY_EW << Animator::SECTION_BOUNDARY_NS;
+    frame << Animator::SECTION_BOUNDARY_EW << Animator::SECTION_BOUNDARY_NS;
+    frame << Animator::SECTION_BOUNDARY_EW << Animator::SECTION_BOUNDARY_NS;
     for (int s = 0; s < numSectionsBefore; s++)
-        std::cout << Animator::SECTION_BOUNDARY_EW << " ";
-    std::cout << std::endl;
+        frame << Animator::SECTION_BOUNDARY_EW << " ";
+    frame << std::endl;
 }
 
 //======================================================================
@@ -267,53 +370,32 @@ void Animator::drawEastbound()
     for (int s = 0; s < numSectionsBefore; s++)
     {
         int section = s;
-        if (westToEast[section] == nullptr)
-            std::cout << Animator::EMPTY_SECTION << "|";
-        else
-            std::cout << getVehicleColor(westToEast[section])
-                      << std::setfill('0') << std::setw(Animator::DIGITS_TO_DRAW)
-                      << westToEast[section]->getVehicleID()
-                      << Animator::COLOR_RESET << "|";
+        drawSection(westToEast, westToEastDensity, section);
+        frame << "|";
     }
 
     // now handle the intersection; the first spot in the west to east lane
     // could be occupied by a vehicle in the W2E lane or in the N2S lane
     VehicleBase* vptr = (westToEast[numSectionsBefore] != nullptr ?
             westToEast[numSectionsBefore] : northToSouth[numSectionsBefore + 1]);
-    if (vptr == nullptr)
-        std::cout << Animator::EMPTY_SECTION << "|";
-    else
-        std::cout << getVehicleColor(vptr)
-                  << std::setfill('0') << std::setw(Animator::DIGITS_TO_DRAW)
-                  << vptr->getVehicleID()
-                  << Animator::COLOR_RESET << "|";
+    drawSection(vptr, -1);
+    frame << "|";
 
     // and the second spot in the west to east lane could be occupied by a
     // vehicle in the W2E lane or in the S2N lane
     vptr = (westToEast[numSectionsBefore + 1] != nullptr ?
             westToEast[numSectionsBefore + 1] : southToNorth[numSectionsBefore]);
-    if (vptr == nullptr)
-        std::cout << Animator::EMPTY_SECTION << "|";
-    else
-        std::cout << getVehicleColor(vptr)
-                  << std::setfill('0') << std::setw(Animator::DIGITS_TO_DRAW)
-                  << vptr->getVehicleID()
-                  << Animator::COLOR_RESET << "|";
+    drawSection(vptr, -1);
+    frame << "|";
 
     // and now handle all the west-to-east sections after the intersection
     for (int s = numSectionsBefore + 2; s < static_cast<int>(westToEast.size()); s++)
     {
         int section = s;
-        if (westToEast[section] == nullptr)
-            std::cout << Animator::EMPTY_SECTION;
-        else
-            std::cout << getVehicleColor(westToEast[section])
-                      << std::setfill('0') << std::setw(Animator::DIGITS_TO_DRAW)
-                      << westToEast[section]->getVehicleID()
-                      << Animator::COLOR_RESET;
-        std::cout << (s < static_cast<int>(westToEast.size()) - 1 ? "|" :  "");
+        drawSection(westToEast, westToEastDensity, section);
+        frame << (s < static_cast<int>(westToEast.size()) - 1 ? "|" :  "");
     }
-    std::cout << std::endl;
+    frame << std::endl;
 
     drawEastWestBoundary();
 }
@@ -330,13 +412,8 @@ void Animator::drawWestbound()
     for (int s = 0; s < numSectionsBefore; s++)
     {
         int section = eastToWest.size() - s - 1;
-        if (eastToWest[section] == nullptr)
-            std::cout << Animator::EMPTY_SECTION << "|";
-        else
-            std::cout << getVehicleColor(eastToWest[section])
-                      << std::setfill('0') << std::setw(Animator::DIGITS_TO_DRAW)
-                      << eastToWest[section]->getVehicleID()
-                      << Animator::COLOR_RESET << "|";
+        drawSection(eastToWest, eastToWestDensity, section);
+        frame << "|";
     }
 
     // now handle the intersection; the first spot encountered L to R in the
@@ -344,41 +421,25 @@ void Animator::drawWestbound()
     // the N2S lane
     VehicleBase* vptr = (eastToWest[numSectionsBefore + 1] != nullptr ?
             eastToWest[numSectionsBefore + 1] : northToSouth[numSectionsBefore]);
-    if (vptr == nullptr)
-        std::cout << Animator::EMPTY_SECTION << "|";
-    else
-        std::cout << getVehicleColor(vptr)
-                  << std::setfill('0') << std::setw(Animator::DIGITS_TO_DRAW)
-                  << vptr->getVehicleID()
-                  << Animator::COLOR_RESET << "|";
+    drawSection(vptr, -1);
+    frame << "|";
 
     // and the second spot encountered L to R in the east to west lane could be
     // occupied by a vehicle in the E2W lane or in the S2N lane
     vptr = (eastToWest[numSectionsBefore] != nullptr ?
             eastToWest[numSectionsBefore] : southToNorth[numSectionsBefore + 1]);
-    if (vptr == nullptr)
-        std::cout << Animator::EMPTY_SECTION << "|";
-    else
-        std::cout << getVehicleColor(vptr)
-                  << std::setfill('0') << std::setw(Animator::DIGITS_TO_DRAW)
-                  << vptr->getVehicleID()
-                  << Animator::COLOR_RESET << "|";
+    drawSection(vptr, -1);
+    frame << "|";
 
     // and now handle all the east-to-west sections after the intersection
     // (drawing in reverse order of the vector)
     for (int s = numSectionsBefore + 2; s < static_cast<int>(eastToWest.size()); s++)
     {
         int section = eastToWest.size() - s - 1;
-        if (eastToWest[section] == nullptr)
-            std::cout << Animator::EMPTY_SECTION;
-        else
-            std::cout << getVehicleColor(eastToWest[section])
-                      << std::setfill('0') << std::setw(Animator::DIGITS_TO_DRAW)
-                      << eastToWest[section]->getVehicleID()
-                      << Animator::COLOR_RESET;
-        std::cout << (s < static_cast<int>(eastToWest.size()) - 1 ? "|" :  "");
+        drawSection(eastToWest, eastToWestDensity, section);
+        frame << (s < static_cast<int>(eastToWest.size()) - 1 ? "|" :  "");
     }
-    std::cout << std::endl;
+    frame << std::endl;
 
 }
 
@@ -392,51 +453,39 @@ void Animator::drawSouthPortion()
         // draw empty spaces to account for E/W lanes to left of intersection
         for (int i = 0; i < numSectionsBefore; i++) 
             if (s == 0 && i == numSectionsBefore - 1)
-                std::cout << (i > 0 ? " " : "") 
+                frame << (i > 0 ? " " : "") 
                           << getTrafficLight(Direction::east); // or west
             else
-                std::cout << (i > 0 ? " " : "") << Animator::EMPTY_SECTION;
+                frame << (i > 0 ? " " : "") << Animator::EMPTY_SECTION;
 
 
-        std::cout << Animator::SECTION_BOUNDARY_NS;
+        frame << Animator::SECTION_BOUNDARY_NS;
 
         // either draw (a portion of) southbound vehicle if present, 
         // or an empty section
         int section = numSectionsBefore + s + 2;
-        if (northToSouth[section] == nullptr)
-            std::cout << Animator::EMPTY_SECTION;
-        else
-            std::cout << getVehicleColor(northToSouth[section])
-                      << std::setfill('0') << std::setw(Animator::DIGITS_TO_DRAW)
-                      << northToSouth[section]->getVehicleID()
-                      << Animator::COLOR_RESET;
+        drawSection(northToSouth, northToSouthDensity, section);
 
-        std::cout << Animator::SECTION_BOUNDARY_NS;
+        frame << Animator::SECTION_BOUNDARY_NS;
 
         // either draw (a portion of) northbound vehicle if present, 
         // or an empty section
         section = numSectionsBefore - s - 1;
-        if (southToNorth[section] == nullptr)
-            std::cout << Animator::EMPTY_SECTION;
-        else
-            std::cout << getVehicleColor(southToNorth[section])
-                      << std::setfill('0') << std::setw(Animator::DIGITS_TO_DRAW)
-                      << southToNorth[section]->getVehicleID()
-                      << Animator::COLOR_RESET;
+        drawSection(southToNorth, southToNorthDensity, section);
 
-        std::cout << Animator::SECTION_BOUNDARY_NS;
+        frame << Animator::SECTION_BOUNDARY_NS;
 
         if (s == 0)
-            std::cout << getTrafficLight(Direction::north);  // or south
+            frame << getTrafficLight(Direction::north);  // or south
             
-        std::cout << std::endl;
+        frame << std::endl;
 
         if (s < numSectionsBefore - 1)  // no need to draw last section spacer
         {
             // draw empty spaces to account for E/W lanes to left of intersection
             for (int i = 0; i < numSectionsBefore; i++) 
-                std::cout << (i > 0 ? " " : "") << Animator::EMPTY_SECTION;
-            std::cout << Animator::SECTION_BOUNDARY_NS << Animator::SECTION_BOUNDARY_EW
+                frame << (i > 0 ? " " : "") << Animator::EMPTY_SECTION;
+            frame << Animator::SECTION_BOUNDARY_NS << Animator::SECTION_BOUNDARY_EW
                       << Animator::SECTION_BOUNDARY_NS << Animator::SECTION_BOUNDARY_EW 
                       << Animator::SECTION_BOUNDARY_NS << std::endl;
         }
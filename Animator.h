@@ -1,8 +1,10 @@
 #ifndef __ANIMATOR_H__
 #define __ANIMATOR_H__
 
+#include <sstream>
 #include <string>
 #include <vector>
+#include "RoadLanes.h"
 #include "VehicleBase.h"
 
 //==========================================================================
@@ -42,6 +44,16 @@
 //*        - if appropriate, call setLightEastWest and setLightNorthSouth passing 
 //*          the updated color
 //*        - call draw(), passing in the value of the simulation time clock
+//*   - render() builds the same frame as draw() and returns it as a string
+//*     (e.g. to record it) instead of printing it
+//*   - for long roads, pass a viewport to the constructor: only the given
+//*     number of sections on each side of the intersection are drawn in
+//*     full, the rest of each half lane is drawn as a few blocks showing
+//*     how full they are (" .:;=+*#%@", empty to full); the setVehicles*
+//*     methods also take a LaneView and then only read the drawn sections
+//*   - vehicle IDs wider than the cells are drawn as '*' followed by their
+//*     last digits (e.g. "*345" for 12345), so two vehicles can show the
+//*     same number; raise MAX_VEHICLE_COUNT to draw wider cells
 //*
 //* Modifications done 18 Nov 2018:
 //*   - added enum classes Direction, VehicleType, and LightColor in
@@ -57,10 +69,12 @@ class Animator
 {
    private:
       static int         DIGITS_TO_DRAW;
+      static int         ID_MODULUS;
       static std::string SECTION_BOUNDARY_EW;
       static std::string EMPTY_SECTION;
       
       static const std::string SECTION_BOUNDARY_NS;
+      static const std::string DENSITY_LEVELS;
       static const std::string ERROR_MSG;
 
       static const std::string COLOR_RED_FG;
@@ -70,6 +84,8 @@ class Animator
       static const std::string COLOR_GREEN_BG;
       static const std::string COLOR_BLUE_BG;
       static const std::string COLOR_YELLOW_BG;
+      static const std::string COLOR_MAGENTA_FG;
+      static const std::string COLOR_MAGENTA_BG;
       static const std::string COLOR_RESET;
 
       static std::string GREEN_LIGHT;
@@ -83,6 +99,12 @@ class Animator
       std::string createLight(LightColor color);
       std::string getTrafficLight(Direction direction);
 
+      void drawSection(VehicleBase* vptr, int density);
+      void drawSection(const std::vector<VehicleBase*>& cells,
+                       const std::vector<int>& density, int section);
+      void setLane(std::vector<VehicleBase*>& cells, std::vector<int>& density,
+                   const LaneView& lane);
+
       void drawNorthPortion(int time);
       void drawEastbound();
       void drawEastWestBoundary();
@@ -97,10 +119,25 @@ class Animator
       std::vector<VehicleBase*> northToSouth;
       std::vector<VehicleBase*> southToNorth;
 
+      // viewport: the drawn lanes above hold numSectionsBefore = viewportSections
+      // + densityBlocks sections per half lane; block cells hold nullptr and
+      // their occupancy (0-9) is in the density vectors (-1 for real sections)
+      int roadSectionsBefore;
+      int viewportSections;
+      int densityBlocks;
+      int blockSize;
+      std::vector<int> eastToWestDensity;
+      std::vector<int> westToEastDensity;
+      std::vector<int> northToSouthDensity;
+      std::vector<int> southToNorthDensity;
+      std::vector<int> blockCounts;
+
+      std::ostringstream frame;  // text of the frame being drawn
+
    public:
       static int MAX_VEHICLE_COUNT;
 
-      Animator(int numSectionsBeforeIntersection);
+      Animator(int numSectionsBeforeIntersection, int viewportSections = 0, int densityBlocks = 0);
       ~Animator();
 
       inline void setLightNorthSouth(LightColor color)
@@ -108,17 +145,27 @@ class Animator
       inline void setLightEastWest(LightColor color)
             { eastWestLightColor = color; }
 
-      inline void setVehiclesNorthbound(std::vector<VehicleBase*> vehicles)
-            { southToNorth = vehicles;  vehiclesAreSet[0] = true; }
-      inline void setVehiclesWestbound(std::vector<VehicleBase*> vehicles)
-            { eastToWest   = vehicles;  vehiclesAreSet[1] = true; }
-      inline void setVehiclesSouthbound(std::vector<VehicleBase*> vehicles)
-            { northToSouth = vehicles;  vehiclesAreSet[2] = true; }
-      inline void setVehiclesEastbound(std::vector<VehicleBase*> vehicles)
-            { westToEast   = vehicles;  vehiclesAreSet[3] = true; }
+      inline void setVehiclesNorthbound(const LaneView& lane)
+            { setLane(southToNorth, southToNorthDensity, lane);  vehiclesAreSet[0] = true; }
+      inline void setVehiclesWestbound(const LaneView& lane)
+            { setLane(eastToWest, eastToWestDensity, lane);  vehiclesAreSet[1] = true; }
+      inline void setVehiclesSouthbound(const LaneView& lane)
+            { setLane(northToSouth, northToSouthDensity, lane);  vehiclesAreSet[2] = true; }
+      inline void setVehiclesEastbound(const LaneView& lane)
+            { setLane(westToEast, westToEastDensity, lane);  vehiclesAreSet[3] = true; }
+
+      inline void setVehiclesNorthbound(const std::vector<VehicleBase*>& vehicles)
+            { setVehiclesNorthbound(LaneView(vehicles.data(), vehicles.size())); }
+      inline void setVehiclesWestbound(const std::vector<VehicleBase*>& vehicles)
+            { setVehiclesWestbound(LaneView(vehicles.data(), vehicles.size())); }
+      inline void setVehiclesSouthbound(const std::vector<VehicleBase*>& vehicles)
+            { setVehiclesSouthbound(LaneView(vehicles.data(), vehicles.size())); }
+      inline void setVehiclesEastbound(const std::vector<VehicleBase*>& vehicles)
+            { setVehiclesEastbound(LaneView(vehicles.data(), vehicles.size())); }
 
 
       void draw(int time);
+      std::string render(int time);  // same frame as draw(), returned instead of printed
 };
 
 #endif
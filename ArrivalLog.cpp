@@ -0,0 +1,260 @@
+#ifndef __ARRIVAL_LOG_CPP__
+#define __ARRIVAL_LOG_CPP__
+
+#include "ArrivalLog.h"
+#include "SimConfig.h"
+
+#include <climits>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+const char ArrivalLog::MAGIC[8] = {'A', 'R', 'R', 'I', 'V', 'A', 'L', '1'};
+
+/*
+ * @param const char* data mapped file (nullptr for an empty file)
+ * @param size_t length
+ */
+ArrivalLog::ArrivalLog(const char* data, size_t length) : data(data), length(length), first(0), binary(false) {
+    if (length >= sizeof(MAGIC) && memcmp(data, MAGIC, sizeof(MAGIC)) == 0) {
+        binary = true;
+        first = sizeof(MAGIC);
+    } else if (length > 0 && (data[0] < '0' || data[0] > '9')) {
+        // header line
+        const char* end = static_cast<const char*>(memchr(data, '\n', length));
+        first = end == nullptr ? length : end - data + 1;
+    }
+}
+
+ArrivalLog::~ArrivalLog() {
+    if (data != nullptr) {
+        munmap(const_cast<char*>(data), length);
+    }
+}
+
+/*
+ * Maps a log file
+ * @param const string& path
+ * @return shared_ptr<const ArrivalLog>
+ * @throws runtime_error if the file can't be opened or mapped
+ */
+shared_ptr<const ArrivalLog> ArrivalLog::open(const string& path) {
+    int descriptor = ::open(path.c_str(), O_RDONLY);
+    if (descriptor < 0) {
+        throw runtime_error("Unable to open file: " + path);
+    }
+    struct stat status;
+    if (fstat(descriptor, &status) != 0) {
+        ::close(descriptor);
+        throw runtime_error("Unable to read file: " + path);
+    }
+
+    size_t length = status.st_size;
+    const char* data = nullptr;
+    if (length > 0) {
+        void* mapped = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, descriptor, 0);
+        if (mapped == MAP_FAILED) {
+            ::close(descriptor);
+            throw runtime_error("Unable to map file: " + path);
+        }
+        // read ahead aggressively, drop pages early
+        madvise(mapped, length, MADV_SEQUENTIAL);
+        data = static_cast<const char*>(mapped);
+    }
+    // the mapping stays valid after the descriptor is closed
+    ::close(descriptor);
+
+    shared_ptr<const ArrivalLog> log(new ArrivalLog(data, length));
+    if (log->isBinary() && (length - log->begin()) % RECORD_BYTES != 0) {
+        throw runtime_error("Truncated arrival log: " + path);
+    }
+    return log;
+}
+
+/*
+ * Reads the record at a position and moves the position to the next one
+ * @param size_t& position cursor, starting at begin()
+ * @param LoggedArrival& arrival receives the record
+ * @return bool false at the end of the log (arrival unchanged)
+ * @throws runtime_error for an invalid record
+ */
+bool ArrivalLog::next(size_t& position, LoggedArrival& arrival) const {
+    if (!binary) {
+        return nextCsv(position, arrival);
+    }
+    if (position + RECORD_BYTES > length) {
+        return false;
+    }
+    const char* record = data + position;
+    int32_t tick;
+    memcpy(&tick, record, sizeof(tick));
+    uint8_t direction = record[4];
+    uint8_t type = record[5];
+    uint8_t turn = record[6];
+    // TurnType::nulled is not a turn a vehicle can arrive with
+    if (tick < 0 || direction > 3 || type >= SimConfig::MAX_VEHICLE_CLASSES || turn > 2) {
+        throw runtime_error("Invalid arrival record at byte " + to_string(position));
+    }
+    arrival.tick = tick;
+    arrival.direction = static_cast<Direction>(direction);
+    arrival.type = static_cast<VehicleType>(type);
+    arrival.turn = static_cast<TurnType>(turn);
+    position += RECORD_BYTES;
+    return true;
+}
+
+/*
+ * @param const char*& p position in a line, moved past the word and its comma
+ * @param const char* end end of the line
+ * @param const char*& word set to the first character of the word
+ * @return size_t length of the word, without the blanks around it
+ */
+static inline size_t nextWord(const char*& p, const char* end, const char*& word) {
+    while (p < end && *p == ' ') {
+        p++;
+    }
+    word = p;
+    while (p < end && *p != ',') {
+        p++;
+    }
+    const char* last = p;
+    while (last > word && (last[-1] == ' ' || last[-1] == '\r')) {
+        last--;
+    }
+    if (p < end) {
+        p++;
+    }
+    return last - word;
+}
+
+/*
+ * @param const char* word
+ * @param size_t length
+ * @param const char* const names[] lower-case names, in the order of their values
+ * @param int count number of names
+ * @param const char* suffix also accepted after a name ("" for none)
+ * @return int index of the name the word is (whole, or its first letter
+ * alone, in any case), -1 if none
+ */
+static int wordIndex(const char* word, size_t length, const char* const names[], int count, const char* suffix) {
+    for (int i = 0; i < count; i++) {
+        size_t name = strlen(names[i]);
+        bool whole = length == name || length == name + strlen(suffix);
+        for (size_t c = 0; whole && c < length; c++) {
+            char expected = c < name ? names[i][c] : suffix[c - name];
+            whole = (word[c] | 0x20) == expected;
+        }
+        if (whole || (length == 1 && (word[0] | 0x20) == names[i][0])) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static const char* const BOUND_NAMES[] = {"north", "south", "east", "west"};
+static const char* const TYPE_NAMES[] = {"car", "suv", "truck"};
+static const char* const TURN_NAMES[] = {"straight", "right", "left"};
+
+/*
+ * CSV version of next(): parses "tick,bound,type,turn" in place
+ */
+bool ArrivalLog::nextCsv(size_t& position, LoggedArrival& arrival) const {
+    // skip blank lines
+    while (position < length && (data[position] == '\n' || data[position] == '\r')) {
+        position++;
+    }
+    if (position >= length) {
+        return false;
+    }
+
+    const char* p = data + position;
+    const char* end = static_cast<const char*>(memchr(p, '\n', length - position));
+    size_t next = end == nullptr ? length : end - data + 1;
+    if (end == nullptr) {
+        end = data + length;
+    }
+
+    int tick = 0;
+    const char* digits = p;
+    bool valid = true;
+    while (p < end && *p >= '0' && *p <= '9') {
+        int digit = *p - '0';
+        if (tick > (INT_MAX - digit) / 10) {
+            valid = false;
+            break;
+        }
+        tick = tick * 10 + digit;
+        p++;
+    }
+    valid = valid && p > digits && p < end && *p == ',';
+    p++;
+
+    const char* word;
+    size_t wordLength = nextWord(p, end, word);
+    int bound = wordIndex(word, wordLength, BOUND_NAMES, 4, "bound");
+    wordLength = nextWord(p, end, word);
+    int type = wordIndex(word, wordLength, TYPE_NAMES, 3, "");
+    if (type < 0 && wordLength > 0 && wordLength <= 2) {
+        // other classes by their VehicleType number
+        int number = 0;
+        for (size_t c = 0; c < wordLength && number >= 0; c++) {
+            number = word[c] >= '0' && word[c] <= '9' ? number * 10 + (word[c] - '0') : -1;
+        }
+        type = number < SimConfig::MAX_VEHICLE_CLASSES ? number : -1;
+    }
+    wordLength = nextWord(p, end, word);
+    int turn = wordIndex(word, wordLength, TURN_NAMES, 3, "");
+
+    valid = valid && bound >= 0 && type >= 0 && turn >= 0;
+    if (valid) {
+        arrival.direction = static_cast<Direction>(bound);
+        arrival.type = static_cast<VehicleType>(type);
+        arrival.turn = static_cast<TurnType>(turn);
+    }
+    if (!valid) {
+        throw runtime_error("Invalid arrival line at byte " + to_string(position) +
+                            " (expected tick,bound,type,turn)");
+    }
+
+    arrival.tick = tick;
+    position = next;
+    return true;
+}
+
+/*
+ * Gives back the pages holding [from, to) (a cursor is past them): they are
+ * read again from the file if ever needed
+ * @param size_t from
+ * @param size_t to
+ */
+void ArrivalLog::release(size_t from, size_t to) const {
+    size_t page = sysconf(_SC_PAGESIZE);
+    size_t start = (from + page - 1) / page * page;
+    size_t stop = to / page * page;
+    if (data != nullptr && stop > start) {
+        madvise(const_cast<char*>(data) + start, stop - start, MADV_DONTNEED);
+    }
+}
+
+/*
+ * Fills a binary record
+ * @param const LoggedArrival& arrival
+ * @param char* record RECORD_BYTES bytes
+ */
+void ArrivalLog::encode(const LoggedArrival& arrival, char* record) {
+    int32_t tick = arrival.tick;
+    memcpy(record, &tick, sizeof(tick));
+    record[4] = static_cast<char>(arrival.direction);
+    record[5] = static_cast<char>(arrival.type);
+    record[6] = static_cast<char>(arrival.turn);
+    record[7] = 0;
+}
+
+#endif
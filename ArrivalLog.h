@@ -0,0 +1,71 @@
+#ifndef __ARRIVAL_LOG_H__
+#define __ARRIVAL_LOG_H__
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include "Vehicle.h"
+#include "VehicleBase.h"
+
+using namespace std;
+
+// One recorded arrival
+struct LoggedArrival {
+    int tick;
+    Direction direction;
+    VehicleType type;
+    TurnType turn;
+};
+
+/*
+ * Recorded arrivals (e.g. detector logs) replayed instead of the random
+ * spawns. The file is memory-mapped read-only and parsed in place by a
+ * sequential cursor, so logs of any size are streamed without being loaded:
+ * pages are read on demand and can be given back once the cursor is past
+ * them. Two formats, told apart by the first bytes:
+ *
+ *   binary  "ARRIVAL1" then 8-byte records: int32 tick, then one byte each
+ *           for the Direction, VehicleType and TurnType values, one unused
+ *   CSV     "tick,bound,type,turn" lines, e.g. "120,north,car,left" for a
+ *           car travelling north (coming from the south approach) that
+ *           turns left; words are matched whole or by their first letter
+ *           alone, in any case (north/northbound/n, car/suv/truck,
+ *           straight/right/left), other vehicle classes are given by their
+ *           VehicleType number, a first line that doesn't start with a
+ *           digit is a header
+ *
+ * Rows must be sorted by tick. The log is immutable, so simulators can share
+ * it, each keeping its own cursor.
+ */
+class ArrivalLog {
+    private:
+        const char* data;
+        size_t length;
+        size_t first;       // offset of the first record
+        bool binary;
+
+        ArrivalLog(const char* data, size_t length);
+
+        bool nextCsv(size_t& position, LoggedArrival& arrival) const;
+
+    public:
+        static const char MAGIC[8];
+        static const size_t RECORD_BYTES = 8;
+
+        ~ArrivalLog();
+        ArrivalLog(const ArrivalLog&) = delete;
+        ArrivalLog& operator=(const ArrivalLog&) = delete;
+
+        static shared_ptr<const ArrivalLog> open(const string& path);
+
+        inline size_t begin() const { return first; }
+        inline size_t size() const { return length; }
+        inline bool isBinary() const { return binary; }
+
+        bool next(size_t& position, LoggedArrival& arrival) const;
+        void release(size_t from, size_t to) const;
+
+        static void encode(const LoggedArrival& arrival, char* record);
+};
+
+#endif
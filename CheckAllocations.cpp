@@ -0,0 +1,163 @@
+#include "Simulator.h"
+#include "SuiteFile.h"
+#include "AllocationTracker.h"
+
+#include <cstdio>
+#include <stdexcept>
+
+using namespace std;
+
+static void printUsage() {
+    cerr << "Usage: ./CheckAllocations [suite_file] [warmup_ticks] [--render]" << endl;
+}
+
+/*
+ * Prints the allocations of every call site
+ * @param const AllocationCount* counts sites counted so far
+ * @param int siteCount
+ * @param int ticks number of ticks the counts cover
+ */
+static void printSites(const AllocationCount* counts, int siteCount, int ticks) {
+    for (int i = 0; i < siteCount; i++) {
+        if (counts[i].count == 0) {
+            continue;
+        }
+        printf("    %-32s %10ld allocations %12ld bytes %10.3f per tick\n", counts[i].site,
+               counts[i].count, counts[i].bytes, static_cast<double>(counts[i].count) / max(1, ticks));
+    }
+}
+
+/*
+ * Runs an entry while counting the heap allocations of every tick
+ * @param const SuiteEntry& entry
+ * @param int warmup ticks during which allocations are allowed (vectors reaching their size)
+ * @param bool render also draw every tick (reported, not checked)
+ * @return bool true if no tick after the warm-up allocated
+ */
+static bool check(const SuiteEntry& entry, int warmup, bool render) {
+    Simulator sim = SuiteFile::makeSimulator(entry);
+    Animator anim(sim.getConfig().roadLen);
+
+    AllocationCount warmupSites[AllocationTracker::MAX_SITES];
+    int warmupSiteCount = 0;
+    long stepAllocations = 0;
+    long renderAllocations = 0;
+    int allocatingTicks = 0;
+    int firstAllocatingTick = -1;
+
+    AllocationTracker::clear();
+    AllocationTracker::start();
+
+    while (!sim.isFinished()) {
+        int tick = sim.getTime();
+        if (tick == warmup) {
+            AllocationTracker::stop();
+            warmupSiteCount = AllocationTracker::getSiteCount();
+            for (int i = 0; i < warmupSiteCount; i++) {
+                warmupSites[i] = AllocationTracker::getSite(i);
+            }
+            AllocationTracker::clear();
+            AllocationTracker::start();
+        }
+
+        long before = AllocationTracker::getTotal();
+        sim.step();
+        long allocations = AllocationTracker::getTotal() - before;
+
+        if (tick >= warmup && allocations > 0) {
+            stepAllocations += allocations;
+            allocatingTicks++;
+            if (firstAllocatingTick < 0) {
+                firstAllocatingTick = tick;
+            }
+        }
+
+        if (render) {
+            AllocationSite site("Animator::render");
+            before = AllocationTracker::getTotal();
+            anim.setLightNorthSouth(sim.getLightNorthSouth());
+            anim.setLightEastWest(sim.getLightEastWest());
+            anim.setVehiclesNorthbound(sim.getLane(Direction::north));
+            anim.setVehiclesWestbound(sim.getLane(Direction::west));
+            anim.setVehiclesSouthbound(sim.getLane(Direction::south));
+            anim.setVehiclesEastbound(sim.getLane(Direction::east));
+            anim.render(tick);
+            if (tick >= warmup) {
+                renderAllocations += AllocationTracker::getTotal() - before;
+            }
+        }
+    }
+    AllocationTracker::stop();
+
+    int steadyTicks = sim.getTime() - warmup;
+    string name = entry.configFile + " seed " + to_string(entry.seed);
+    cout << name << " (" << sim.getLaneEngineName() << " lanes)" << endl;
+    cout << "  warm-up (" << min(warmup, sim.getTime()) << " ticks):" << endl;
+    if (warmupSiteCount == 0 && warmup >= sim.getTime()) {
+        warmupSiteCount = AllocationTracker::getSiteCount();
+        for (int i = 0; i < warmupSiteCount; i++) {
+            warmupSites[i] = AllocationTracker::getSite(i);
+        }
+    }
+    printSites(warmupSites, warmupSiteCount, warmup);
+
+    if (steadyTicks <= 0) {
+        cout << "  no ticks after the warm-up" << endl;
+        return true;
+    }
+    cout << "  steady state (" << steadyTicks << " ticks):" << endl;
+    AllocationCount steadySites[AllocationTracker::MAX_SITES];
+    int steadySiteCount = AllocationTracker::getSiteCount();
+    for (int i = 0; i < steadySiteCount; i++) {
+        steadySites[i] = AllocationTracker::getSite(i);
+    }
+    printSites(steadySites, steadySiteCount, steadyTicks);
+    if (render) {
+        cout << "  drawing: " << renderAllocations << " allocations ("
+             << static_cast<double>(renderAllocations) / steadyTicks << " per frame, not checked)" << endl;
+    }
+
+    if (stepAllocations > 0) {
+        cout << "  FAILED: " << stepAllocations << " allocations in " << allocatingTicks
+             << " ticks, first at tick " << firstAllocatingTick << endl;
+        return false;
+    }
+    cout << "  OK: no allocation per tick after the warm-up" << endl;
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+
+    if (argc < 2 || argc > 4) {
+        printUsage();
+        exit(0);
+    }
+
+    if (!AllocationTracker::isLinked()) {
+        cerr << "CheckAllocations must be linked with CountingNew.o" << endl;
+        return 2;
+    }
+
+    try {
+        vector<SuiteEntry> suite = SuiteFile::read(argv[1]);
+        int warmup = 100;
+        bool render = false;
+        for (int a = 2; a < argc; a++) {
+            string option = argv[a];
+            if (option == "--render") {
+                render = true;
+            } else {
+                warmup = stoi(option);
+            }
+        }
+
+        bool allPassed = true;
+        for (const SuiteEntry& entry : suite) {
+            allPassed = check(entry, warmup, render) && allPassed;
+        }
+        return allPassed ? 0 : 1;
+    } catch (const exception& e) {
+        cerr << e.what() << endl;
+        return 2;
+    }
+}
@@ -0,0 +1,174 @@
+#include "Simulator.h"
+#include "SuiteFile.h"
+#include "ResultCache.h"
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <unistd.h>
+
+using namespace std;
+
+static void printUsage() {
+    cerr << "Usage: ./CheckCache [suite_file]" << endl;
+    cerr << "Checks that the result cache returns a stored run only for the same configuration, seed" << endl;
+    cerr << "and engine, and that trimming removes the least recently used runs first" << endl;
+}
+
+/*
+ * @param const RunStatistics& a
+ * @param const RunStatistics& b
+ * @return bool true if every total is the same
+ */
+static bool sameTotals(const RunStatistics& a, const RunStatistics& b) {
+    return a.arrivals == b.arrivals && a.exited == b.exited && a.totalTravelTime == b.totalTravelTime &&
+           a.totalDelay == b.totalDelay && a.queueLengthSum == b.queueLengthSum && a.ticks == b.ticks && a.stalled == b.stalled;
+}
+
+/*
+ * @param const string& directory
+ * @return vector<string> paths of the stored runs
+ */
+static vector<string> storedRuns(const string& directory) {
+    vector<string> paths;
+    for (const auto& entry : filesystem::directory_iterator(directory)) {
+        if (entry.path().extension() == ".run") {
+            paths.push_back(entry.path().string());
+        }
+    }
+    return paths;
+}
+
+/*
+ * Hits and misses of one entry, in an empty directory: the first run is
+ * stored, the same run is then found with the totals of a run without the
+ * cache, while a changed parameter, another seed or a file stored by
+ * another engine version are not
+ * @param const SuiteEntry& entry
+ * @param const string& directory
+ * @return string what went wrong (empty if nothing)
+ */
+static string checkKeys(const SuiteEntry& entry, const string& directory) {
+    Simulator sim = SuiteFile::makeSimulator(entry);
+    sim.step(sim.getConfig().simTime);
+    RunStatistics live = sim.getStatistics();
+
+    ResultCache cache(directory);
+    RunStatistics statistics;
+    if (cache.lookup(sim.getConfig(), entry.seed, statistics)) {
+        return "found in an empty cache";
+    }
+    if (!sameTotals(cache.run(sim, entry.seed), live) || storedRuns(directory).size() != 1) {
+        return "first run not stored with the totals of a run without the cache";
+    }
+    if (!cache.lookup(sim.getConfig(), entry.seed, statistics) || !sameTotals(statistics, live)) {
+        return "same run not found, or found with other totals";
+    }
+    if (!sameTotals(cache.run(sim, entry.seed), live) || storedRuns(directory).size() != 1) {
+        return "second run not taken from the cache";
+    }
+
+    map<string, double> parameters = sim.getConfig().getParameters();
+    parameters["green_north_south"] += 1;
+    if (cache.lookup(SimConfig::fromParameters(parameters), entry.seed, statistics)) {
+        return "found after a parameter changed";
+    }
+    if (cache.lookup(sim.getConfig(), entry.seed + 1, statistics)) {
+        return "found for another seed";
+    }
+
+    // the same file, as another engine version would have written it
+    string path = storedRuns(directory)[0];
+    stringstream contents;
+    contents << ifstream(path).rdbuf();
+    string text = contents.str();
+    string engine = "engine " + to_string(ENGINE_VERSION) + "\n";
+    if (text.compare(0, engine.size(), engine) != 0) {
+        return "stored run doesn't start with the engine version";
+    }
+    ofstream(path) << "engine " << ENGINE_VERSION + 1 << "\n" << text.substr(engine.size());
+    if (cache.lookup(sim.getConfig(), entry.seed, statistics)) {
+        return "found in a file of another engine version";
+    }
+    return "";
+}
+
+/*
+ * Trimming: three runs are stored, the first one is used again, then a
+ * fourth run takes the store over its limit. The second run, used least
+ * recently, must be the one removed. The steps are a few milliseconds apart:
+ * file times only advance with the kernel clock tick.
+ * @param const SuiteEntry& entry
+ * @param const string& directory empty
+ * @return string what went wrong (empty if nothing)
+ */
+static string checkTrim(const SuiteEntry& entry, const string& directory) {
+    Simulator sim = SuiteFile::makeSimulator(entry);
+    const SimConfig& config = sim.getConfig();
+    {
+        ResultCache unlimited(directory);
+        for (int r = 0; r < 3; r++) {
+            unlimited.run(sim, entry.seed + r);
+            this_thread::sleep_for(chrono::milliseconds(20));
+        }
+    }
+    long bytes = 0;
+    for (const string& path : storedRuns(directory)) {
+        bytes += filesystem::file_size(path);
+    }
+
+    // room for three and a half runs; checked at every store
+    ResultCache cache(directory, bytes + bytes / 6);
+    RunStatistics statistics;
+    if (!cache.lookup(config, entry.seed, statistics)) {
+        return "first run not found before trimming";
+    }
+    this_thread::sleep_for(chrono::milliseconds(20));
+    cache.run(sim, entry.seed + 3);
+
+    bool kept[4];
+    for (int r = 0; r < 4; r++) {
+        kept[r] = cache.lookup(config, entry.seed + r, statistics);
+    }
+    if (!kept[0] || kept[1] || !kept[2] || !kept[3]) {
+        return string("runs kept after trimming: ") + (kept[0] ? "0 " : "") + (kept[1] ? "1 " : "") +
+               (kept[2] ? "2 " : "") + (kept[3] ? "3 " : "") + "(expected 0 2 3)";
+    }
+    return "";
+}
+
+int main(int argc, char* argv[]) {
+
+    if (argc != 2) {
+        printUsage();
+        exit(0);
+    }
+
+    filesystem::path directory = filesystem::temp_directory_path() / ("CheckCache_" + to_string(getpid()));
+    try {
+        vector<SuiteEntry> suite = SuiteFile::read(argv[1]);
+        bool passed = true;
+        for (size_t e = 0; e < suite.size(); e++) {
+            const SuiteEntry& entry = suite[e];
+            string name = entry.configFile + " seed " + to_string(entry.seed);
+            filesystem::remove_all(directory);
+            string failure = checkKeys(entry, directory.string());
+            // trimming doesn't depend on the configuration: one entry is enough
+            if (failure.empty() && e == 0) {
+                filesystem::remove_all(directory);
+                failure = checkTrim(entry, directory.string());
+            }
+            cout << name << ": " << (failure.empty() ? "OK" : "FAILED: " + failure) << endl;
+            passed = passed && failure.empty();
+        }
+        filesystem::remove_all(directory);
+        return passed ? 0 : 1;
+    } catch (const exception& e) {
+        filesystem::remove_all(directory);
+        cerr << e.what() << endl;
+        return 2;
+    }
+}
@@ -0,0 +1,209 @@
+#include "Simulator.h"
+#include "StateHash.h"
+#include "SuiteFile.h"
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+
+using namespace std;
+
+static const char GOLDEN_MAGIC[4] = {'T', 'L', 'S', 'G'};
+static const uint32_t GOLDEN_VERSION = 1;
+
+static void printUsage() {
+    cerr << "Usage: ./CheckDeterminism record [suite_file] [golden_dir]" << endl;
+    cerr << "       ./CheckDeterminism verify [suite_file] [golden_dir]" << endl;
+    cerr << "       ./CheckDeterminism compare [suite_file]" << endl;
+}
+
+static string goldenPath(const string& goldenDir, const SuiteEntry& entry) {
+    string stem = filesystem::path(entry.configFile).stem().string();
+    return (filesystem::path(goldenDir) / (stem + "_" + to_string(entry.seed) + ".golden")).string();
+}
+
+template <class T>
+static void writeValue(ofstream& out, T value) {
+    out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+template <class T>
+static bool readValue(ifstream& in, T& value) {
+    return static_cast<bool>(in.read(reinterpret_cast<char*>(&value), sizeof(value)));
+}
+
+/*
+ * Runs an entry and stores the digest of every tick
+ */
+static void record(const SuiteEntry& entry, const string& path) {
+    Simulator sim = SuiteFile::makeSimulator(entry);
+    StateHash stateHash;
+    TickDigest digest;
+
+    ofstream out {path, ios::binary};
+    if (!out) {
+        throw runtime_error("Unable to write golden file: " + path);
+    }
+    out.write(GOLDEN_MAGIC, sizeof(GOLDEN_MAGIC));
+    writeValue(out, GOLDEN_VERSION);
+    writeValue(out, static_cast<int32_t>(entry.ticks));
+
+    while (!sim.isFinished()) {
+        sim.step();
+        stateHash.update(sim, digest);
+        writeValue(out, digest.hash);
+        writeValue(out, digest.globalHash);
+        writeValue(out, static_cast<uint32_t>(digest.vehicles.size()));
+        out.write(reinterpret_cast<const char*>(digest.vehicles.data()),
+                  digest.vehicles.size() * sizeof(VehicleDigest));
+    }
+    cout << "recorded " << path << " (" << sim.getTime() << " ticks)" << endl;
+}
+
+/*
+ * Explains the first difference between a recorded tick and the current one
+ */
+static string describeDivergence(const TickDigest& expected, const TickDigest& actual) {
+    size_t n = min(expected.vehicles.size(), actual.vehicles.size());
+    for (size_t k = 0; k < n; k++) {
+        const VehicleDigest& e = expected.vehicles[k];
+        const VehicleDigest& a = actual.vehicles[k];
+        if (e.id != a.id) {
+            return "vehicle " + to_string(e.id) + " expected, found vehicle " + to_string(a.id);
+        }
+        if (e.hash != a.hash) {
+            return "vehicle " + to_string(e.id) + " has a different position or state";
+        }
+    }
+    if (expected.vehicles.size() > n) {
+        return "vehicle " + to_string(expected.vehicles[n].id) + " is missing";
+    }
+    if (actual.vehicles.size() > n) {
+        return "unexpected vehicle " + to_string(actual.vehicles[n].id);
+    }
+    if (expected.globalHash != actual.globalHash) {
+        return "lights, section reservations or entry queues differ";
+    }
+    return "state of an earlier tick differs";
+}
+
+/*
+ * Runs an entry and compares every tick with the recorded digests
+ * @return bool true if the whole stream matches
+ */
+static bool verify(const SuiteEntry& entry, const string& path) {
+    ifstream in {path, ios::binary};
+    char magic[4];
+    uint32_t version;
+    int32_t ticks;
+    if (!in || !in.read(magic, sizeof(magic)) || !equal(magic, magic + 4, GOLDEN_MAGIC) ||
+            !readValue(in, version) || version != GOLDEN_VERSION || !readValue(in, ticks)) {
+        throw runtime_error("Missing or invalid golden file: " + path);
+    }
+
+    Simulator sim = SuiteFile::makeSimulator(entry);
+    StateHash stateHash;
+    TickDigest actual;
+    TickDigest expected;
+
+    string name = entry.configFile + " seed " + to_string(entry.seed);
+
+    while (!sim.isFinished()) {
+        int tick = sim.getTime();
+        sim.step();
+        stateHash.update(sim, actual);
+
+        uint32_t count;
+        if (!readValue(in, expected.hash) || !readValue(in, expected.globalHash) || !readValue(in, count)) {
+            cout << name << ": golden stream ends at tick " << tick << endl;
+            return false;
+        }
+        expected.vehicles.resize(count);
+        in.read(reinterpret_cast<char*>(expected.vehicles.data()), count * sizeof(VehicleDigest));
+
+        if (expected.hash != actual.hash) {
+            cout << name << ": DIVERGED at tick " << tick << ": "
+                 << describeDivergence(expected, actual) << endl;
+            return false;
+        }
+    }
+    cout << name << ": OK (" << sim.getTime() << " ticks)" << endl;
+    return true;
+}
+
+/*
+ * Runs an entry on a lane storage and on the dynamic one side by side and
+ * compares them tick by tick
+ * @param LaneEngine engine lane storage to check (automatic: the one chosen for the road length)
+ * @return bool true if both engines produce the same trajectory
+ */
+static bool compareEngines(const SuiteEntry& entry, LaneEngine engine) {
+    Simulator selected = SuiteFile::makeSimulator(entry);
+    Simulator dynamic = SuiteFile::makeSimulator(entry);
+    selected.setLaneEngine(engine);
+    dynamic.setLaneEngine(LaneEngine::dynamic);
+
+    StateHash selectedHash;
+    StateHash dynamicHash;
+    TickDigest expected;
+    TickDigest actual;
+
+    string name = entry.configFile + " seed " + to_string(entry.seed) + " " +
+                  selected.getLaneEngineName() + " vs " + dynamic.getLaneEngineName();
+
+    while (!selected.isFinished()) {
+        int tick = selected.getTime();
+        selected.step();
+        dynamic.step();
+        selectedHash.update(selected, actual);
+        dynamicHash.update(dynamic, expected);
+
+        if (expected.hash != actual.hash) {
+            cout << name << ": DIVERGED at tick " << tick << ": "
+                 << describeDivergence(expected, actual) << endl;
+            return false;
+        }
+    }
+    cout << name << ": OK (" << selected.getTime() << " ticks)" << endl;
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+
+    string mode = argc > 1 ? argv[1] : "";
+
+    if (argc != 4 && !(argc == 3 && mode == "compare")) {
+        printUsage();
+        exit(0);
+    }
+
+    try {
+        vector<SuiteEntry> suite = SuiteFile::read(argv[2]);
+        string goldenDir = argc > 3 ? argv[3] : "";
+        bool allMatch = true;
+
+        if (mode == "compare") {
+            for (const SuiteEntry& entry : suite) {
+                allMatch = compareEngines(entry, LaneEngine::automatic) && allMatch;
+                allMatch = compareEngines(entry, LaneEngine::queue) && allMatch;
+            }
+        } else if (mode == "record") {
+            filesystem::create_directories(goldenDir);
+            for (const SuiteEntry& entry : suite) {
+                record(entry, goldenPath(goldenDir, entry));
+            }
+        } else if (mode == "verify") {
+            for (const SuiteEntry& entry : suite) {
+                allMatch = verify(entry, goldenPath(goldenDir, entry)) && allMatch;
+            }
+        } else {
+            printUsage();
+            exit(0);
+        }
+        return allMatch ? 0 : 1;
+    } catch (const exception& e) {
+        cerr << e.what() << endl;
+        return 2;
+    }
+}
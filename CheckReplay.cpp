@@ -0,0 +1,146 @@
+#include "Simulator.h"
+#include "SuiteFile.h"
+#include "ReplayFile.h"
+
+#include <cstdio>
+#include <filesystem>
+#include <random>
+#include <stdexcept>
+#include <unistd.h>
+
+using namespace std;
+
+static void printUsage() {
+    cerr << "Usage: ./CheckReplay [suite_file] [keyframe_every] [random_seeks]" << endl;
+    cerr << "Records every run of the suite and checks that seeking the recording to random ticks," << endl;
+    cerr << "forward and back, shows the lanes and lights the simulator had at those ticks" << endl;
+}
+
+// What the simulator showed after one tick, in the section codes of the recording
+struct LiveFrame {
+    LightColor northSouth;
+    LightColor eastWest;
+    vector<int64_t> codes;      // north, south, east, west bounds one after the other
+};
+
+/*
+ * @param const ReplayPlayer& player positioned on a tick
+ * @param const LiveFrame& live the simulator at that tick
+ * @param int sections per bound
+ * @return string what differs (empty if nothing)
+ */
+static string difference(const ReplayPlayer& player, const LiveFrame& live, int sections) {
+    if (player.getLightNorthSouth() != live.northSouth || player.getLightEastWest() != live.eastWest) {
+        return "lights differ";
+    }
+    for (int bound = 0; bound < 4; bound++) {
+        LaneView lane = player.getLane(static_cast<Direction>(bound));
+        for (int section = 0; section < sections; section++) {
+            if (ReplayRecorder::encode(lane[section]) != live.codes[bound * sections + section]) {
+                return "bound " + to_string(bound) + " section " + to_string(section) + " differs";
+            }
+        }
+    }
+    return "";
+}
+
+/*
+ * Records an entry, then seeks the recording: every tick in order, random
+ * ticks each followed by a nearby one (so forward and back, within and
+ * across keyframe intervals), then every tick from the last to the first
+ * @param const SuiteEntry& entry
+ * @param int keyframeEvery
+ * @param int seeks number of random seeks
+ * @param const string& path temporary recording
+ * @return bool true if every tick shown matched the simulator
+ */
+static bool check(const SuiteEntry& entry, int keyframeEvery, int seeks, const string& path) {
+    Simulator sim = SuiteFile::makeSimulator(entry);
+    int roadLen = sim.getConfig().roadLen;
+    int sections = roadLen * 2 + 2;
+    vector<LiveFrame> live;
+    vector<VehicleBase*> cells(sections);
+    {
+        ReplayRecorder recorder(path, roadLen, keyframeEvery);
+        while (!sim.isFinished()) {
+            sim.step();
+            recorder.record(sim);
+            LiveFrame frame{sim.getLightNorthSouth(), sim.getLightEastWest(), {}};
+            for (int bound = 0; bound < 4; bound++) {
+                sim.getLane(static_cast<Direction>(bound)).copyRange(0, sections - 1, cells.data());
+                for (VehicleBase* vehicle : cells) {
+                    frame.codes.push_back(ReplayRecorder::encode(vehicle));
+                }
+            }
+            live.push_back(move(frame));
+        }
+        recorder.close();
+    }
+
+    string name = entry.configFile + " seed " + to_string(entry.seed);
+    int ticks = live.size();
+    if (ticks == 0) {
+        cout << name << ": no ticks to record" << endl;
+        return true;
+    }
+
+    ReplayPlayer player(path);
+    vector<int> order;
+    for (int tick = 0; tick < ticks; tick++) {
+        order.push_back(tick);
+    }
+    // a random tick, then one near it (back or forward, often in the same keyframe interval)
+    mt19937 random(entry.seed);
+    for (int s = 0; s < seeks; s++) {
+        int tick = uniform_int_distribution<int>(0, ticks - 1)(random);
+        int near = tick + uniform_int_distribution<int>(-keyframeEvery, keyframeEvery)(random);
+        order.push_back(tick);
+        order.push_back(min(max(near, 0), ticks - 1));
+    }
+    for (int tick = ticks - 1; tick >= 0; tick--) {
+        order.push_back(tick);
+    }
+
+    int previous = player.getTick();
+    for (int tick : order) {
+        int target = player.getFirstTick() + tick;
+        player.seek(target);
+        string differs = player.getTick() != target ? "shows tick " + to_string(player.getTick())
+                                                    : difference(player, live[tick], sections);
+        if (!differs.empty()) {
+            cout << name << ": FAILED seeking from tick " << previous << " to tick " << target << ": " << differs
+                 << endl;
+            return false;
+        }
+        previous = target;
+    }
+    cout << name << ": OK (" << ticks << " ticks, keyframe every " << keyframeEvery << ", " << order.size()
+         << " seeks)" << endl;
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+
+    if (argc < 2 || argc > 4) {
+        printUsage();
+        exit(0);
+    }
+
+    string path = (filesystem::temp_directory_path() / ("CheckReplay_" + to_string(getpid()) + ".bin")).string();
+    try {
+        vector<SuiteEntry> suite = SuiteFile::read(argv[1]);
+        int keyframeEvery = argc > 2 ? stoi(argv[2]) : 7;
+        int seeks = argc > 3 ? stoi(argv[3]) : 500;
+
+        bool passed = true;
+        for (const SuiteEntry& entry : suite) {
+            passed = check(entry, keyframeEvery, seeks, path) && passed;
+        }
+        remove(path.c_str());
+        return passed ? 0 : 1;
+    } catch (const exception& e) {
+        remove(path.c_str());
+        cerr << e.what() << endl;
+        return 2;
+    }
+}
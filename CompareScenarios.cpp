@@ -0,0 +1,121 @@
+#include "Simulator.h"
+#include "SampleStatistics.h"
+#include "ResultCache.h"
+
+#include <cstdio>
+#include <memory>
+#include <stdexcept>
+
+using namespace std;
+
+// Output measures compared between scenarios
+static const int METRICS = KPI_COUNT;
+
+static void printUsage() {
+    cerr << "Usage: ./CompareScenarios [replications] [first_seed] [config_file] [config_file] ... [--independent] [--cache DIR]" << endl;
+    cerr << "Runs every configuration with the same seeds and paired random streams and" << endl;
+    cerr << "reports the differences with the first one (--independent: different seeds)" << endl;
+    cerr << "--cache DIR reuses the results of runs stored in DIR (and stores new ones)" << endl;
+}
+
+int main(int argc, char* argv[]) {
+
+    vector<string> files;
+    bool independent = false;
+    string cacheDirectory;
+    for (int a = 3; a < argc; a++) {
+        string argument = argv[a];
+        if (argument == "--independent") {
+            independent = true;
+        } else if (argument == "--cache" && a + 1 < argc) {
+            cacheDirectory = argv[++a];
+        } else {
+            files.push_back(argument);
+        }
+    }
+
+    if (argc < 5 || files.size() < 2) {
+        printUsage();
+        exit(0);
+    }
+
+    try {
+        int replications = stoi(argv[1]);
+        int firstSeed = stoi(argv[2]);
+        int scenarios = files.size();
+        unique_ptr<ResultCache> cache;
+        if (!cacheDirectory.empty()) {
+            cache.reset(new ResultCache(cacheDirectory));
+        }
+
+        // one simulator per scenario, reset for every replication
+        vector<unique_ptr<Simulator>> simulators;
+        for (const string& file : files) {
+            map<string, double> parameters = SimConfig::fromFile(file).getParameters();
+            parameters["paired_random_streams"] = 1;
+            simulators.emplace_back(new Simulator(SimConfig::fromParameters(parameters), firstSeed));
+        }
+
+        // per scenario and metric, then per compared scenario and metric
+        vector<SampleStatistics> values(scenarios * METRICS);
+        vector<SampleStatistics> differences(scenarios * METRICS);
+        vector<int> stalled(scenarios, 0);
+
+        for (int r = 0; r < replications; r++) {
+            double baseline[METRICS];
+            for (int s = 0; s < scenarios; s++) {
+                Simulator& sim = *simulators[s];
+                int seed = independent ? firstSeed + r * scenarios + s : firstSeed + r;
+                RunStatistics statistics;
+                if (cache) {
+                    statistics = cache->run(sim, seed);
+                } else {
+                    sim.reset(seed);
+                    sim.step(sim.getConfig().simTime);
+                    statistics = sim.getStatistics();
+                }
+
+                stalled[s] += statistics.stalled;
+
+                for (int m = 0; m < METRICS; m++) {
+                    double value = statistics.getKpi(static_cast<Kpi>(m));
+                    values[s * METRICS + m].add(value);
+                    if (s == 0) {
+                        baseline[m] = value;
+                    } else {
+                        differences[s * METRICS + m].add(value - baseline[m]);
+                    }
+                }
+            }
+        }
+
+        cout << replications << " replications, " << (independent ? "independent seeds" : "paired random streams")
+             << ", 95% confidence intervals" << endl;
+        for (int s = 1; s < scenarios; s++) {
+            cout << endl << files[s] << " - " << files[0] << endl;
+            printf("  %-22s %12s %12s %22s %12s\n", "", "first", "this", "difference", "var. ratio");
+            for (int m = 0; m < METRICS; m++) {
+                const SampleStatistics& first = values[m];
+                const SampleStatistics& other = values[s * METRICS + m];
+                const SampleStatistics& difference = differences[s * METRICS + m];
+                // variance of the difference of independent runs over the variance of the paired one
+                double ratio = difference.getVariance() > 0 ?
+                    (first.getVariance() + other.getVariance()) / difference.getVariance() : 0;
+                printf("  %-22s %12.4f %12.4f %10.4f +- %8.4f %12.1f\n",
+                       RunStatistics::kpiLabel(static_cast<Kpi>(m)).c_str(),
+                       first.getMean(), other.getMean(), difference.getMean(),
+                       difference.getHalfWidth(), ratio);
+            }
+        }
+        cout << endl << "var. ratio: replications saved by pairing (about 1 for independent seeds)" << endl;
+        for (int s = 0; s < scenarios; s++) {
+            if (stalled[s] > 0) {
+                cout << files[s] << ": " << stalled[s] << " of " << replications
+                     << " runs stalled and were aborted (stall_ticks)" << endl;
+            }
+        }
+    } catch (const exception& e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+}
@@ -0,0 +1,350 @@
+#ifndef __CONTROL_CHANNEL_CPP__
+#define __CONTROL_CHANNEL_CPP__
+
+#include "ControlChannel.h"
+
+#include <cerrno>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace std;
+
+// Longest command line accepted (a client sending more without a newline is disconnected)
+static const size_t MAX_LINE = 4096;
+
+static const char* LIGHT_NAMES[] = {"green", "yellow", "red"};
+
+/*
+ * Creates the socket (replacing a stale one at the same path) and starts
+ * accepting connections
+ * @param const string& path of the socket
+ * @throws runtime_error if the socket can't be created
+ */
+ControlChannel::ControlChannel(const string& path)
+        : path(path), listener(-1), pending(false), closing(false), paused(false), stopping(false), stepsLeft(0),
+          stepClient(-1), holds(0) {
+    sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address.sun_path)) {
+        throw runtime_error("Control socket path too long: " + path);
+    }
+    strcpy(address.sun_path, path.c_str());
+
+    listener = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (listener < 0) {
+        throw runtime_error("Unable to create control socket: " + path);
+    }
+    unlink(path.c_str());
+    if (bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || listen(listener, 8) != 0) {
+        ::close(listener);
+        throw runtime_error("Unable to create control socket: " + path + " (" + strerror(errno) + ")");
+    }
+    if (pipe2(wake, O_CLOEXEC | O_NONBLOCK) != 0) {
+        ::close(listener);
+        unlink(path.c_str());
+        throw runtime_error("Unable to create control socket: " + path);
+    }
+    connections = thread(&ControlChannel::run, this);
+}
+
+ControlChannel::~ControlChannel() {
+    close();
+}
+
+/*
+ * Disconnects the clients and removes the socket (called by the destructor)
+ */
+void ControlChannel::close() {
+    if (!connections.joinable()) {
+        return;
+    }
+    closing = true;
+    char byte = 0;
+    if (write(wake[1], &byte, 1) < 0) {
+        // the thread also sees closing at its next wake-up
+    }
+    connections.join();
+    ::close(listener);
+    ::close(wake[0]);
+    ::close(wake[1]);
+    unlink(path.c_str());
+}
+
+/*
+ * Connection thread: accepts clients, splits what they send into commands
+ * for poll() and sends them the replies
+ */
+void ControlChannel::run() {
+    struct Client {
+        long id;
+        int fd;
+        string received;
+    };
+    vector<Client> clients;
+    vector<pollfd> watched;
+    long nextClient = 0;
+
+    while (!closing) {
+        watched.assign({{listener, POLLIN, 0}, {wake[0], POLLIN, 0}});
+        for (const Client& client : clients) {
+            watched.push_back({client.fd, POLLIN, 0});
+        }
+        if (::poll(watched.data(), watched.size(), -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+
+        // replies first: a client reading them may be about to send more
+        if (watched[1].revents != 0) {
+            char bytes[64];
+            if (read(wake[0], bytes, sizeof(bytes)) < 0) {
+                // nothing to drain
+            }
+            deque<Command> outgoing;
+            {
+                lock_guard<mutex> guard(lock);
+                outgoing.swap(replies);
+            }
+            for (const Command& reply : outgoing) {
+                for (const Client& client : clients) {
+                    if (client.id != reply.client) {
+                        continue;
+                    }
+                    string text = reply.line + "\n";
+                    size_t sent = 0;
+                    while (sent < text.size()) {
+                        ssize_t count = send(client.fd, text.data() + sent, text.size() - sent, MSG_NOSIGNAL);
+                        if (count <= 0) {
+                            break;
+                        }
+                        sent += count;
+                    }
+                }
+            }
+        }
+
+        // clients that sent something (or hung up)
+        for (size_t c = 0; c < clients.size(); c++) {
+            if (watched[2 + c].revents == 0) {
+                continue;
+            }
+            Client& client = clients[c];
+            char bytes[1024];
+            ssize_t count = read(client.fd, bytes, sizeof(bytes));
+            if (count > 0) {
+                client.received.append(bytes, count);
+                size_t end;
+                while ((end = client.received.find('\n')) != string::npos) {
+                    string line = client.received.substr(0, end);
+                    client.received.erase(0, end + 1);
+                    if (!line.empty() && line.back() == '\r') {
+                        line.pop_back();
+                    }
+                    if (line.find_first_not_of(" \t") == string::npos) {
+                        continue;
+                    }
+                    lock_guard<mutex> guard(lock);
+                    commands.push_back(Command{client.id, line});
+                    pending.store(true, memory_order_release);
+                    arrived.notify_one();
+                }
+            }
+            if (count <= 0 || client.received.size() > MAX_LINE) {
+                ::close(client.fd);
+                client.fd = -1;
+            }
+        }
+        for (size_t c = clients.size(); c-- > 0;) {
+            if (clients[c].fd < 0) {
+                clients.erase(clients.begin() + c);
+            }
+        }
+
+        if (watched[0].revents & POLLIN) {
+            int fd = accept4(listener, nullptr, nullptr, SOCK_CLOEXEC);
+            if (fd >= 0) {
+                clients.push_back(Client{nextClient++, fd, ""});
+            }
+        }
+    }
+
+    for (const Client& client : clients) {
+        ::close(client.fd);
+    }
+}
+
+/*
+ * Queues a reply for the connection thread (simulation thread)
+ * @param long client
+ * @param const string& text one line, without the newline
+ */
+void ControlChannel::reply(long client, const string& text) {
+    {
+        lock_guard<mutex> guard(lock);
+        replies.push_back(Command{client, text});
+    }
+    char byte = 0;
+    if (write(wake[1], &byte, 1) < 0) {
+        // the pipe is full: the thread is already going to wake up
+    }
+}
+
+/*
+ * Slow path of poll(): runs the received commands, then sleeps while the run
+ * is paused and has no steps to make
+ * @param Simulator& sim
+ * @return bool false if the run must stop
+ */
+bool ControlChannel::serve(Simulator& sim) {
+    for (;;) {
+        if (stepClient >= 0 && stepsLeft == 0) {
+            reply(stepClient, "ok paused at tick " + to_string(sim.getTime()));
+            stepClient = -1;
+        }
+
+        deque<Command> received;
+        {
+            unique_lock<mutex> guard(lock);
+            if (paused && stepsLeft == 0) {
+                holds++;
+                arrived.wait(guard, [this] { return !commands.empty(); });
+            }
+            received.swap(commands);
+            pending.store(false, memory_order_relaxed);
+        }
+        for (const Command& command : received) {
+            execute(sim, command);
+        }
+
+        if (stopping) {
+            return false;
+        }
+        if (!paused) {
+            return true;
+        }
+        if (stepsLeft > 0) {
+            stepsLeft--;
+            return true;
+        }
+    }
+}
+
+/*
+ * Runs one command and replies to its client
+ * @param Simulator& sim
+ * @param const Command& command
+ */
+void ControlChannel::execute(Simulator& sim, const Command& command) {
+    istringstream words(command.line);
+    string verb;
+    words >> verb;
+    string tick = to_string(sim.getTime());
+
+    if (verb == "pause") {
+        paused = true;
+        stepsLeft = 0;
+        reply(command.client, "ok paused at tick " + tick);
+    } else if (verb == "resume") {
+        paused = false;
+        stepsLeft = 0;
+        if (stepClient >= 0) {
+            reply(stepClient, "ok running from tick " + tick);
+            stepClient = -1;
+        }
+        reply(command.client, "ok running from tick " + tick);
+    } else if (verb == "step") {
+        int ticks = 1;
+        if (!(words >> ticks)) {
+            ticks = 1;
+        }
+        if (ticks < 1) {
+            reply(command.client, "error step needs at least 1 tick");
+            return;
+        }
+        if (stepClient >= 0 && stepClient != command.client) {
+            reply(stepClient, "ok paused at tick " + tick);
+        }
+        paused = true;
+        stepsLeft = ticks;
+        stepClient = command.client;
+    } else if (verb == "stats") {
+        reply(command.client, "ok " + snapshot(sim));
+    } else if (verb == "get" || verb == "set") {
+        string name;
+        double value;
+        if (!(words >> name) || (verb == "set" && !(words >> value))) {
+            reply(command.client, "error expected: " + verb + (verb == "set" ? " NAME VALUE" : " NAME"));
+            return;
+        }
+        name = SimConfig::normalizeName(name);
+        map<string, double> parameters = sim.getConfig().getParameters();
+        auto parameter = parameters.find(name);
+        if (parameter == parameters.end()) {
+            reply(command.client, "error unknown parameter: " + name);
+            return;
+        }
+        if (verb == "get") {
+            ostringstream text;
+            text.precision(17);
+            text << "ok " << name << " " << parameter->second;
+            reply(command.client, text.str());
+            return;
+        }
+        if (!Simulator::isRetimable(name) && !Simulator::isDemandParameter(name)) {
+            reply(command.client, "error " + name + " can't change during a run (light durations, "
+                                  "maximum_simulated_time, prob_new_vehicle_* and proportion_* can)");
+            return;
+        }
+        try {
+            parameter->second = value;
+            SimConfig config = SimConfig::fromParameters(parameters);
+            if (Simulator::isRetimable(name)) {
+                sim.retime(config);
+                reply(command.client, "ok " + name + " changes at the end of the running light cycle");
+            } else {
+                sim.redemand(config);
+                reply(command.client, "ok " + name + " changes from tick " + tick);
+            }
+        } catch (const exception& e) {
+            reply(command.client, string("error ") + e.what());
+        }
+    } else if (verb == "stop") {
+        stopping = true;
+        reply(command.client, "ok stopping at tick " + tick);
+    } else {
+        reply(command.client, "error unknown command: " + verb +
+                              " (pause, resume, step [N], stats, get NAME, set NAME VALUE, stop)");
+    }
+}
+
+/*
+ * @param const Simulator& sim
+ * @return string "name=value" pairs describing the run so far
+ */
+string ControlChannel::snapshot(const Simulator& sim) {
+    const RunStatistics& statistics = sim.getStatistics();
+    ostringstream text;
+    text << "tick=" << sim.getTime() << " arrivals=" << statistics.arrivals << " exited=" << statistics.exited;
+    for (int k = 0; k < KPI_COUNT; k++) {
+        text << " " << RunStatistics::kpiName(static_cast<Kpi>(k)) << "=" << statistics.getKpi(static_cast<Kpi>(k));
+    }
+    text << " vehicles=" << sim.getVehicles().size()
+         << " queues=" << sim.getQueueLength(Direction::north) << "," << sim.getQueueLength(Direction::south)
+         << "," << sim.getQueueLength(Direction::east) << "," << sim.getQueueLength(Direction::west)
+         << " lights=" << LIGHT_NAMES[static_cast<int>(sim.getLightNorthSouth())] << ","
+         << LIGHT_NAMES[static_cast<int>(sim.getLightEastWest())]
+         << " dropped=" << sim.getDroppedSpawns() << " stalled=" << (sim.isStalled() ? 1 : 0);
+    return text.str();
+}
+
+#endif
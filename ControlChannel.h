@@ -0,0 +1,90 @@
+#ifndef __CONTROL_CHANNEL_H__
+#define __CONTROL_CHANNEL_H__
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "Simulator.h"
+
+using namespace std;
+
+/*
+ * Local control of a running simulation through a Unix domain socket: any
+ * number of clients (e.g. "socat - UNIX-CONNECT:path") send one command per
+ * line and get one reply line, "ok ..." or "error ...":
+ *
+ *   pause                  stop before the next tick
+ *   resume                 run again
+ *   step [N]               run N ticks (default 1), then pause
+ *   stats                  totals and queues so far (the run goes on)
+ *   get NAME               value of a parameter
+ *   set NAME VALUE         change a light duration or maximum_simulated_time
+ *                          (from the end of the running cycle, see retime())
+ *                          or a prob_new_vehicle_* or proportion_* parameter
+ *                          (from the next tick, see redemand())
+ *   stop                   end the run now
+ *
+ * A background thread owns the socket and the connections; commands are run
+ * by the simulation thread in poll(), between two ticks, so they never see a
+ * tick half done. Until a command arrives poll() costs one atomic load, and a
+ * paused run sleeps until the next command instead of spinning.
+ */
+class ControlChannel {
+    private:
+        struct Command {
+            long client;
+            string line;
+        };
+
+        string path;
+        int listener;
+        int wake[2];                    // pipe waking the thread up for replies or closing
+        thread connections;
+
+        mutex lock;
+        condition_variable arrived;
+        deque<Command> commands;
+        deque<Command> replies;
+        atomic<bool> pending;           // commands is not empty
+        atomic<bool> closing;
+
+        // simulation thread only
+        bool paused;
+        bool stopping;
+        int stepsLeft;
+        long stepClient;                // waiting for the end of its steps (-1: none)
+        long holds;                     // times poll() waited on a paused run
+
+        void run();
+        void reply(long client, const string& text);
+        bool serve(Simulator& sim);
+        void execute(Simulator& sim, const Command& command);
+        static string snapshot(const Simulator& sim);
+
+    public:
+        explicit ControlChannel(const string& path);
+        ~ControlChannel();
+        ControlChannel(const ControlChannel&) = delete;
+        ControlChannel& operator=(const ControlChannel&) = delete;
+
+        /*
+         * Runs the commands received since the last call, and waits while the
+         * run is paused (simulation thread, between ticks)
+         * @param Simulator& sim
+         * @return bool false if the run must stop
+         */
+        inline bool poll(Simulator& sim) {
+            return !(pending.load(memory_order_acquire) || paused) || serve(sim);
+        }
+
+        void close();
+
+        inline bool isPaused() const { return paused; }
+        inline long getHolds() const { return holds; }
+        inline const string& getPath() const { return path; }
+};
+
+#endif
@@ -0,0 +1,65 @@
+#include "ArrivalLog.h"
+
+#include <cstdio>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+using namespace std;
+
+// Bytes written at once
+static const size_t BATCH_BYTES = 1 << 20;
+
+static void printUsage() {
+    cerr << "Usage: ./ConvertArrivals [csv_log] [binary_log]" << endl;
+    cerr << "Converts a tick,bound,type,turn arrival log to the binary format (faster to replay)" << endl;
+}
+
+int main(int argc, char* argv[]) {
+
+    if (argc != 3) {
+        printUsage();
+        exit(0);
+    }
+
+    try {
+        shared_ptr<const ArrivalLog> log = ArrivalLog::open(argv[1]);
+        FILE* output = fopen(argv[2], "wb");
+        if (output == nullptr) {
+            throw runtime_error(string("Unable to open file: ") + argv[2]);
+        }
+
+        vector<char> batch(BATCH_BYTES);
+        size_t used = sizeof(ArrivalLog::MAGIC);
+        copy(ArrivalLog::MAGIC, ArrivalLog::MAGIC + sizeof(ArrivalLog::MAGIC), batch.begin());
+
+        size_t position = log->begin();
+        size_t released = position;
+        LoggedArrival arrival;
+        long count = 0;
+        int lastTick = 0;
+        while (log->next(position, arrival)) {
+            if (arrival.tick < lastTick) {
+                throw runtime_error("Arrivals not sorted by tick at row " + to_string(count + 1));
+            }
+            lastTick = arrival.tick;
+            if (used + ArrivalLog::RECORD_BYTES > batch.size()) {
+                fwrite(batch.data(), 1, used, output);
+                used = 0;
+                log->release(released, position);
+                released = position;
+            }
+            ArrivalLog::encode(arrival, batch.data() + used);
+            used += ArrivalLog::RECORD_BYTES;
+            count++;
+        }
+        fwrite(batch.data(), 1, used, output);
+        if (fclose(output) != 0) {
+            throw runtime_error(string("Unable to write file: ") + argv[2]);
+        }
+        cout << count << " arrivals written to " << argv[2] << endl;
+    } catch (const exception& e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+}
@@ -0,0 +1,52 @@
+#ifndef __COUNTING_NEW_CPP__
+#define __COUNTING_NEW_CPP__
+
+// Global operator new that reports every allocation to AllocationTracker.
+// Only link this into programs that measure allocations (CheckAllocations).
+
+#include "AllocationTracker.h"
+
+#include <cstdlib>
+#include <new>
+
+bool allocationCountingLinked = true;
+
+void* operator new(size_t bytes) {
+    AllocationTracker::record(bytes);
+    void* memory = malloc(bytes == 0 ? 1 : bytes);
+    if (memory == nullptr) {
+        throw bad_alloc();
+    }
+    return memory;
+}
+
+void* operator new[](size_t bytes) {
+    return operator new(bytes);
+}
+
+void* operator new(size_t bytes, const nothrow_t&) noexcept {
+    AllocationTracker::record(bytes);
+    return malloc(bytes == 0 ? 1 : bytes);
+}
+
+void* operator new[](size_t bytes, const nothrow_t&) noexcept {
+    return operator new(bytes, nothrow);
+}
+
+void operator delete(void* memory) noexcept {
+    free(memory);
+}
+
+void operator delete[](void* memory) noexcept {
+    free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept {
+    free(memory);
+}
+
+void operator delete[](void* memory, size_t) noexcept {
+    free(memory);
+}
+
+#endif
@@ -0,0 +1,272 @@
+#ifndef __DEMAND_PROFILE_CPP__
+#define __DEMAND_PROFILE_CPP__
+
+#include "DemandProfile.h"
+
+#include <algorithm>
+#include <fstream>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+
+using namespace std;
+
+static const char* BOUND_NAMES[4] = {"northbound", "southbound", "eastbound", "westbound"};
+
+// Proportions that may be given per bound, followed by the name of a vehicle class
+static const char* PROPORTION_PREFIXES[3] = {"proportion_of_", "proportion_right_turn_", "proportion_left_turn_"};
+
+DemandProfile::DemandProfile() : linear(false), period(0), resolution(1) {}
+
+/*
+ * Reads a profile: "interpolation: step|linear", "period: ticks",
+ * "resolution: ticks" and "tick parameter value" lines, '#' starts a comment
+ * @param const string& file
+ * @return DemandProfile
+ * @throws runtime_error if the file can't be read or a line is invalid
+ */
+DemandProfile DemandProfile::fromFile(const string& file) {
+    ifstream infile {file};
+
+    if (!infile) {
+        throw runtime_error("Unable to open file: " + file);
+    }
+
+    DemandProfile profile;
+    string line;
+    int lineNumber = 0;
+    while (getline(infile, line)) {
+        lineNumber++;
+        line = line.substr(0, line.find('#'));
+        istringstream words(line);
+        string first;
+        if (!(words >> first)) {
+            continue;
+        }
+
+        string where = " (" + file + " line " + to_string(lineNumber) + ")";
+        string name = SimConfig::normalizeName(first);
+        string value;
+        if (name == "interpolation") {
+            if (!(words >> value) || (value != "step" && value != "linear")) {
+                throw runtime_error("interpolation must be step or linear" + where);
+            }
+            profile.setLinear(value == "linear");
+            continue;
+        }
+
+        int number;
+        if (name == "period" || name == "resolution") {
+            if (!(words >> number)) {
+                throw runtime_error("Invalid value for " + name + where);
+            }
+            if (name == "period") {
+                profile.setPeriod(number);
+            } else {
+                profile.setResolution(number);
+            }
+            continue;
+        }
+
+        double parameterValue;
+        istringstream tick(first);
+        if (!(tick >> number) || !(words >> value >> parameterValue)) {
+            throw runtime_error("Expected: tick parameter value" + where);
+        }
+        profile.addBreakpoint(number, value, parameterValue);
+    }
+
+    return profile;
+}
+
+/*
+ * @param int tick from the start of the run (or of the period)
+ * @param const string& parameter prob_new_vehicle_<bound> or proportion_*,
+ * optionally followed by _<bound> (the vehicle class is checked by DemandTable)
+ * @param double value
+ * @throws runtime_error for an unknown parameter or a negative tick
+ */
+void DemandProfile::addBreakpoint(int tick, const string& parameter, double value) {
+    string name = SimConfig::normalizeName(parameter);
+    bool known = false;
+    for (const char* bound : BOUND_NAMES) {
+        known = known || name == string("prob_new_vehicle_") + bound;
+    }
+    for (const char* prefix : PROPORTION_PREFIXES) {
+        string start = prefix;
+        known = known || (name.size() > start.size() && name.compare(0, start.size(), start) == 0);
+    }
+    if (!known) {
+        throw runtime_error("Unknown demand parameter: " + name);
+    }
+    if (tick < 0) {
+        throw runtime_error("Demand breakpoints must not have a negative tick");
+    }
+
+    vector<pair<int, double>>& points = breakpoints[name];
+    auto position = lower_bound(points.begin(), points.end(), make_pair(tick, value),
+                                [](const pair<int, double>& a, const pair<int, double>& b) { return a.first < b.first; });
+    if (position != points.end() && position->first == tick) {
+        position->second = value;
+    } else {
+        points.insert(position, make_pair(tick, value));
+    }
+}
+
+/*
+ * @param const string& parameter
+ * @param int tick
+ * @param double defaultValue returned when the parameter has no breakpoint
+ * @return double value of the parameter at the tick (held before the first
+ * breakpoint and after the last one)
+ */
+double DemandProfile::valueAt(const string& parameter, int tick, double defaultValue) const {
+    auto found = breakpoints.find(parameter);
+    if (found == breakpoints.end()) {
+        return defaultValue;
+    }
+    const vector<pair<int, double>>& points = found->second;
+
+    // first breakpoint after the tick
+    auto after = upper_bound(points.begin(), points.end(), tick,
+                             [](int t, const pair<int, double>& point) { return t < point.first; });
+    if (after == points.begin()) {
+        return after->second;
+    }
+    auto before = after - 1;
+    if (!linear || after == points.end()) {
+        return before->second;
+    }
+    double fraction = static_cast<double>(tick - before->first) / (after->first - before->first);
+    return before->second + fraction * (after->second - before->second);
+}
+
+/*
+ * @param int period ticks after which the profile repeats, 0 for never
+ */
+void DemandProfile::setPeriod(int period) {
+    if (period < 0) {
+        throw runtime_error("Demand period must not be negative");
+    }
+    this->period = period;
+}
+
+/*
+ * @param int resolution ticks sharing one compiled level (the profile is
+ * sampled at the first tick of every block)
+ */
+void DemandProfile::setResolution(int resolution) {
+    if (resolution < 1) {
+        throw runtime_error("Demand resolution must be at least 1");
+    }
+    this->resolution = resolution;
+}
+
+/*
+ * Samples the profile at the start of every block of ticks
+ * @param const SimConfig& config values of the parameters without breakpoints,
+ * vehicle classes, and length of the run when the profile doesn't repeat
+ * @param const DemandProfile* profile nullptr for the constant demand of config
+ * @throws runtime_error if a sampled value is out of range or the profile
+ * names a vehicle class the configuration doesn't have
+ */
+DemandTable::DemandTable(const SimConfig& config, const DemandProfile* profile) {
+    DemandProfile constant;
+    if (profile == nullptr) {
+        profile = &constant;
+    }
+
+    // a profile without breakpoints is the constant demand: a single level
+    int levelCount = 1;
+    resolution = 1;
+    cycle = 1;
+    if (!profile->isConstant()) {
+        resolution = profile->getResolution();
+        int ticks = profile->getPeriod() > 0 ? profile->getPeriod() : max(config.simTime, 1);
+        levelCount = (ticks + resolution - 1) / resolution;
+        cycle = profile->getPeriod() > 0 ? profile->getPeriod() : levelCount * resolution;
+    }
+
+    // trucks are drawn last, taking whatever the other classes leave
+    const vector<VehicleClass>& classes = config.vehicleClasses;
+    int types = classes.size();
+    for (int k = 0; k < types; k++) {
+        if (static_cast<VehicleType>(k) != VehicleType::truck) {
+            drawingOrder.push_back(static_cast<VehicleType>(k));
+        }
+    }
+    drawingOrder.push_back(VehicleType::truck);
+
+    // proportions of the classes in drawing order (but trucks), then the
+    // right and left turns of every class in VehicleType order
+    vector<string> names;
+    vector<double> proportions;
+    for (int k = 0; k < types - 1; k++) {
+        const VehicleClass& vehicleClass = classes[static_cast<int>(drawingOrder[k])];
+        names.push_back("proportion_of_" + vehicleClass.name);
+        proportions.push_back(vehicleClass.proportion);
+    }
+    for (const VehicleClass& vehicleClass : classes) {
+        names.push_back("proportion_right_turn_" + vehicleClass.name);
+        proportions.push_back(vehicleClass.proportionRight);
+        names.push_back("proportion_left_turn_" + vehicleClass.name);
+        proportions.push_back(vehicleClass.proportionLeft);
+    }
+    int stride = names.size();
+
+    set<string> known;
+    for (const char* bound : BOUND_NAMES) {
+        known.insert(string("prob_new_vehicle_") + bound);
+        for (const string& name : names) {
+            known.insert(name);
+            known.insert(name + "_" + bound);
+        }
+    }
+    for (const auto& breakpoints : profile->getBreakpoints()) {
+        if (known.count(breakpoints.first) == 0) {
+            throw runtime_error("Unknown demand parameter: " + breakpoints.first);
+        }
+    }
+
+    double rates[4] = {config.probNB, config.probSB, config.probEB, config.probWB};
+
+    levels.resize(levelCount);
+    thresholds.resize(static_cast<size_t>(levelCount) * 4 * stride);
+    vector<double> value(stride);
+    for (int k = 0; k < levelCount; k++) {
+        int tick = k * resolution;
+        string where = " (demand at tick " + to_string(tick) + ")";
+        for (int b = 0; b < 4; b++) {
+            string bound = BOUND_NAMES[b];
+            BoundDemand& demand = levels[k].bounds[b];
+
+            // with Poisson arrivals the rates may exceed one vehicle per tick
+            demand.arrival = profile->valueAt("prob_new_vehicle_" + bound, tick, rates[b]);
+            if (demand.arrival < 0 || (demand.arrival > 1 && !config.poissonArrivals)) {
+                throw runtime_error("prob_new_vehicle_* must be between 0 and 1 (or a rate >= 0 with poisson_arrivals)" + where);
+            }
+
+            for (int p = 0; p < stride; p++) {
+                value[p] = profile->valueAt(names[p] + "_" + bound, tick, profile->valueAt(names[p], tick, proportions[p]));
+                if (value[p] < 0 || value[p] > 1) {
+                    throw runtime_error("probabilities and proportions must be between 0 and 1" + where);
+                }
+            }
+
+            double* typeThresholds = &thresholds[(static_cast<size_t>(k) * 4 + b) * stride];
+            double* turnThresholds = typeThresholds + types - 1;
+            for (int t = 0; t < types - 1; t++) {
+                typeThresholds[t] = t == 0 ? value[0] : typeThresholds[t - 1] + value[t];
+            }
+            for (int type = 0; type < types; type++) {
+                const double* turns = &value[types - 1 + 2 * type];
+                turnThresholds[2 * type] = turns[0];
+                turnThresholds[2 * type + 1] = turns[0] + turns[1];
+            }
+            demand.typeThresholds = typeThresholds;
+            demand.turnThresholds = turnThresholds;
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,99 @@
+#ifndef __DEMAND_PROFILE_H__
+#define __DEMAND_PROFILE_H__
+
+#include <map>
+#include <string>
+#include <vector>
+#include "SimConfig.h"
+#include "VehicleBase.h"
+
+using namespace std;
+
+/*
+ * Demand that changes over the day, read from a profile file (see
+ * demand_profile_format.txt): breakpoints "tick parameter value" for any of
+ * the prob_new_vehicle_* and proportion_* parameters, the proportions either
+ * for all bounds or for one (suffix _northbound, _southbound, ...). Between
+ * breakpoints the values are held (step) or interpolated (linear). Parameters
+ * without breakpoints keep the value of the configuration. Proportions of a
+ * vehicle class the configuration doesn't have are rejected by DemandTable.
+ */
+class DemandProfile {
+    private:
+        map<string, vector<pair<int, double>>> breakpoints;  // sorted by tick
+        bool linear;
+        int period;         // ticks after which the profile repeats (0: never)
+        int resolution;     // ticks sharing one compiled level
+
+    public:
+        DemandProfile();
+
+        static DemandProfile fromFile(const string& file);
+
+        void addBreakpoint(int tick, const string& parameter, double value);
+        double valueAt(const string& parameter, int tick, double defaultValue) const;
+
+        inline const map<string, vector<pair<int, double>>>& getBreakpoints() const { return breakpoints; }
+        inline bool isConstant() const { return breakpoints.empty(); }
+        inline bool isLinear() const { return linear; }
+        inline int getPeriod() const { return period; }
+        inline int getResolution() const { return resolution; }
+        inline void setLinear(bool linear) { this->linear = linear; }
+        void setPeriod(int period);
+        void setResolution(int resolution);
+};
+
+// Arrivals of one bound and the cumulative thresholds that turn the type and
+// turn draws of a new vehicle into its type and turn (held by the DemandTable)
+struct BoundDemand {
+    double arrival;                 // probability (or Poisson rate) per tick
+    const double* typeThresholds;   // cars, cars + SUVs, ... in drawing order (trucks are the rest)
+    const double* turnThresholds;   // per VehicleType: right, right + left
+};
+
+// Demand of the four bounds (indexed by Direction) during one block of ticks
+struct DemandLevel {
+    BoundDemand bounds[4];
+};
+
+/*
+ * A demand profile compiled against a configuration: one DemandLevel per
+ * block of resolution ticks, so the simulation finds the demand of a tick
+ * with one index computation instead of interpolating. Without a profile the
+ * table holds the constant demand of the configuration. Vehicle classes are
+ * drawn as cars, SUVs, the classes of the input file, then trucks, so a
+ * configuration without extra classes draws as it always did. Immutable after
+ * construction.
+ */
+class DemandTable {
+    private:
+        int resolution;
+        int cycle;          // ticks covered by the levels (the period of a repeating profile)
+        vector<DemandLevel> levels;
+        vector<double> thresholds;          // pointed to by the levels
+        vector<VehicleType> drawingOrder;
+
+    public:
+        DemandTable(const SimConfig& config, const DemandProfile* profile = nullptr);
+        DemandTable(const DemandTable&) = delete;
+        DemandTable& operator=(const DemandTable&) = delete;
+
+        inline const DemandLevel& at(int tick) const { return levels[(tick % cycle) / resolution]; }
+
+        /*
+         * @param const BoundDemand& demand
+         * @param double typeProb uniform draw in [0, 1)
+         * @return VehicleType class of the new vehicle
+         */
+        inline VehicleType typeOf(const BoundDemand& demand, double typeProb) const {
+            int k = 0;
+            int last = drawingOrder.size() - 1;
+            while (k < last && typeProb > demand.typeThresholds[k]) {
+                k++;
+            }
+            return drawingOrder[k];
+        }
+        inline int getLevelCount() const { return levels.size(); }
+};
+
+#endif
@@ -0,0 +1,48 @@
+#ifndef __ENTRY_QUEUE_CPP__
+#define __ENTRY_QUEUE_CPP__
+
+#include "EntryQueue.h"
+
+#include <stdexcept>
+
+using namespace std;
+
+EntryQueue::EntryQueue(int capacity) : buffer(capacity), head(0), count(0) {}
+
+/*
+ * Appends a vehicle at the back of the queue
+ * @param const PendingVehicle& vehicle
+ * @return bool false if the queue is full (the vehicle is not stored)
+ */
+bool EntryQueue::push(const PendingVehicle& vehicle) {
+    if (full()) {
+        return false;
+    }
+    buffer[(head + count) % buffer.size()] = vehicle;
+    count++;
+    return true;
+}
+
+/*
+ * Removes the vehicle at the front of the queue
+ * @return PendingVehicle the vehicle that arrived first
+ */
+PendingVehicle EntryQueue::pop() {
+    if (empty()) {
+        throw runtime_error("EntryQueue::pop called on an empty queue");
+    }
+    PendingVehicle vehicle = buffer[head];
+    head = (head + 1) % buffer.size();
+    count--;
+    return vehicle;
+}
+
+/*
+ * Removes all waiting vehicles (the capacity is kept)
+ */
+void EntryQueue::clear() {
+    head = 0;
+    count = 0;
+}
+
+#endif
@@ -0,0 +1,44 @@
+#ifndef __ENTRY_QUEUE_H__
+#define __ENTRY_QUEUE_H__
+
+#include <vector>
+#include "Vehicle.h"
+#include "VehicleBase.h"
+
+using namespace std;
+
+// A vehicle that has arrived but is still waiting off the map
+struct PendingVehicle {
+    int id;
+    int spawnTick;
+    VehicleType type;
+    TurnType turn;
+};
+
+/*
+ * Fixed-capacity ring buffer of vehicles waiting to enter one bound. Arrivals
+ * are kept in order and released into section 0 as soon as it is free; the
+ * buffer is allocated once, so queueing never touches the heap.
+ */
+class EntryQueue {
+    private:
+        vector<PendingVehicle> buffer;
+        int head;
+        int count;
+
+    public:
+        EntryQueue(int capacity = 0);
+
+        bool push(const PendingVehicle& vehicle);
+        PendingVehicle pop();
+        void clear();
+
+        inline bool empty() const { return count == 0; }
+        inline bool full() const { return count == static_cast<int>(buffer.size()); }
+        inline int size() const { return count; }
+        inline int capacity() const { return buffer.size(); }
+        inline const PendingVehicle& front() const { return buffer[head]; }
+        inline const PendingVehicle& at(int i) const { return buffer[(head + i) % buffer.size()]; }
+};
+
+#endif
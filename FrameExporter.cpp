@@ -0,0 +1,191 @@
+#ifndef __FRAME_EXPORTER_CPP__
+#define __FRAME_EXPORTER_CPP__
+
+#include "FrameExporter.h"
+
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <stdexcept>
+
+/*
+ * Opens the output file and starts the writer thread
+ * @param const std::string& path file to write
+ * @param FrameFormat format asciicast or raw ANSI
+ * @param int every record one frame out of every ticks
+ * @param size_t slots number of frames that can wait for the writer
+ * @param double secondsPerTick playback time of one tick (asciicast only)
+ * @throws std::runtime_error if the file can't be opened
+ */
+FrameExporter::FrameExporter(const std::string& path, FrameFormat format, int every,
+                             size_t slots, double secondsPerTick)
+    : ring(slots), format(format), every(every < 1 ? 1 : every),
+      secondsPerTick(secondsPerTick), file(path, std::ios::binary),
+      headerWritten(false), closing(false), dropped(0), written(0)
+{
+    if (!file) {
+        throw std::runtime_error("Unable to open export file: " + path);
+    }
+    output.reserve(BATCH_BYTES + (BATCH_BYTES >> 2));
+    writer = std::thread(&FrameExporter::run, this);
+}
+
+FrameExporter::~FrameExporter()
+{
+    close();
+}
+
+/*
+ * @param const std::string& path
+ * @return FrameFormat asciicast for files ending in .cast, raw otherwise
+ */
+FrameFormat FrameExporter::formatFor(const std::string& path)
+{
+    const std::string extension = ".cast";
+    if (path.size() >= extension.size() &&
+            path.compare(path.size() - extension.size(), extension.size(), extension) == 0)
+        return FrameFormat::asciicast;
+    return FrameFormat::raw;
+}
+
+/*
+ * Queues a frame for the writer thread; never blocks. The frame is dropped
+ * (and counted) if all buffers are waiting to be written
+ * @param int time simulation time of the frame
+ * @param const std::string& frame text printed by the Animator
+ */
+void FrameExporter::submit(int time, const std::string& frame)
+{
+    Frame* slot = ring.beginPush();
+    if (slot == nullptr) {
+        dropped++;
+        return;
+    }
+    slot->time = time;
+    slot->text.assign(frame);   // reuses the buffer's capacity
+    ring.commitPush();
+}
+
+/*
+ * Writes the remaining frames and closes the file (called by the destructor)
+ */
+void FrameExporter::close()
+{
+    if (!writer.joinable()) {
+        return;
+    }
+    closing = true;
+    writer.join();
+    flushOutput();
+    file.close();
+}
+
+/*
+ * Writer thread: moves frames from the ring into the batch buffer and writes
+ * the batch whenever it is large enough
+ */
+void FrameExporter::run()
+{
+    while (true) {
+        Frame* frame = ring.front();
+        if (frame != nullptr) {
+            append(*frame);
+            ring.pop();
+            written++;
+            if (output.size() >= BATCH_BYTES) {
+                flushOutput();
+            }
+        } else if (closing) {
+            // frames submitted before close() are visible once closing is
+            if (ring.front() == nullptr) {
+                break;
+            }
+        } else {
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+        }
+    }
+}
+
+/*
+ * Adds one frame to the batch buffer in the output format
+ * @param const Frame& frame
+ */
+void FrameExporter::append(const Frame& frame)
+{
+    if (format == FrameFormat::raw) {
+        output += frame.text;
+        return;
+    }
+
+    if (!headerWritten) {
+        writeHeader(frame.text);
+    }
+
+    // [time, "o", "data"] with the data escaped as a JSON string
+    char time[32];
+    std::snprintf(time, sizeof(time), "[%.3f, \"o\", \"", frame.time * secondsPerTick);
+    output += time;
+    for (char c : frame.text) {
+        switch (c) {
+            case '"':  output += "\\\""; break;
+            case '\\': output += "\\\\"; break;
+            case '\n': output += "\\r\\n"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    char escaped[8];
+                    std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+                    output += escaped;
+                } else {
+                    output += c;
+                }
+        }
+    }
+    output += "\"]\n";
+}
+
+/*
+ * Writes the asciicast header; the terminal size is measured on the first frame
+ * @param const std::string& text first frame
+ */
+void FrameExporter::writeHeader(const std::string& text)
+{
+    int width = 0;
+    int height = 0;
+    int column = 0;
+    bool escape = false;
+    for (char c : text) {
+        if (escape) {
+            // escape sequences end with a letter
+            escape = !((c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z'));
+        } else if (c == '\x1B') {
+            escape = true;
+        } else if (c == '\n') {
+            height++;
+            column = 0;
+        } else {
+            column++;
+            if (column > width) width = column;
+        }
+    }
+
+    char header[160];
+    std::snprintf(header, sizeof(header),
+                  "{\"version\": 2, \"width\": %d, \"height\": %d, \"timestamp\": %ld}\n",
+                  width, height + 2, static_cast<long>(std::time(nullptr)));
+    output += header;
+    headerWritten = true;
+}
+
+/*
+ * Writes the batch buffer to the file in one call
+ */
+void FrameExporter::flushOutput()
+{
+    if (output.empty()) {
+        return;
+    }
+    file.write(output.data(), output.size());
+    output.clear();
+}
+
+#endif
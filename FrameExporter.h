@@ -0,0 +1,64 @@
+#ifndef __FRAME_EXPORTER_H__
+#define __FRAME_EXPORTER_H__
+
+#include <atomic>
+#include <fstream>
+#include <string>
+#include <thread>
+#include "SpscRing.h"
+
+enum class FrameFormat {asciicast, raw};
+
+/*
+ * Records animation frames to a file without slowing the simulation down.
+ * submit() copies a frame into a fixed ring of reusable buffers and returns
+ * immediately; a background thread drains the ring and writes the file in
+ * large sequential chunks, either as an asciicast v2 recording (.cast, can be
+ * replayed with "asciinema play") or as a raw ANSI log (can be replayed with
+ * "cat"). When the writer falls behind and the ring is full, new frames are
+ * dropped and counted, so memory use stays bounded.
+ */
+class FrameExporter {
+    private:
+        struct Frame {
+            int time;
+            std::string text;
+        };
+
+        static const size_t BATCH_BYTES = 1 << 20;
+
+        SpscRing<Frame> ring;
+        FrameFormat format;
+        int every;
+        double secondsPerTick;
+
+        std::ofstream file;
+        std::string output;           // batch waiting to be written (writer thread only)
+        bool headerWritten;
+
+        std::atomic<bool> closing;
+        std::atomic<long> dropped;
+        std::atomic<long> written;
+        std::thread writer;
+
+        void run();
+        void append(const Frame& frame);
+        void writeHeader(const std::string& text);
+        void flushOutput();
+
+    public:
+        FrameExporter(const std::string& path, FrameFormat format, int every = 1,
+                      size_t slots = 1024, double secondsPerTick = 0.1);
+        ~FrameExporter();
+
+        static FrameFormat formatFor(const std::string& path);
+
+        inline bool wants(int time) const { return time % every == 0; }
+        void submit(int time, const std::string& frame);
+        void close();
+
+        inline long getDropped() const { return dropped; }
+        inline long getWritten() const { return written; }
+};
+
+#endif
@@ -0,0 +1,167 @@
+#ifndef __LIFETIME_WRITER_CPP__
+#define __LIFETIME_WRITER_CPP__
+
+#include "LifetimeWriter.h"
+
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+
+const char LifetimeWriter::MAGIC[8] = {'L', 'I', 'F', 'E', 'T', 'I', 'M', '1'};
+
+static const char* DIRECTION_NAMES[] = {"north", "south", "east", "west"};
+static const char* TURN_NAMES[] = {"straight", "right", "left", "none"};
+
+/*
+ * Opens the output files and starts the writer thread
+ * @param const std::string& path columnar binary file
+ * @param const std::string& csvPath CSV copy of the records (none if empty)
+ * @param size_t slots number of records that can wait for the writer
+ * @throws std::runtime_error if a file can't be opened
+ */
+LifetimeWriter::LifetimeWriter(const std::string& path, const std::string& csvPath, size_t slots)
+    : ring(slots), file(nullptr), csvFile(nullptr), typeNames{"car", "suv", "truck"}, closing(false), written(0),
+      waits(0)
+{
+    file = std::fopen(path.c_str(), "wb");
+    if (file == nullptr) {
+        throw std::runtime_error("Unable to open lifetime file: " + path);
+    }
+    if (!csvPath.empty()) {
+        csvFile = std::fopen(csvPath.c_str(), "w");
+        if (csvFile == nullptr) {
+            std::fclose(file);
+            throw std::runtime_error("Unable to open lifetime file: " + csvPath);
+        }
+        std::fputs("id,type,bound,turn,spawn_tick,entry_tick,exit_tick,stopped_ticks\n", csvFile);
+        csv.reserve(BATCH_RECORDS * 48);
+    }
+    std::fwrite(MAGIC, 1, sizeof(MAGIC), file);
+
+    batch.reserve(BATCH_RECORDS);
+    columns.resize(sizeof(int32_t) + BATCH_RECORDS * sizeof(LifetimeRecord));
+    writer = std::thread(&LifetimeWriter::run, this);
+}
+
+LifetimeWriter::~LifetimeWriter()
+{
+    close();
+}
+
+/*
+ * Writes the remaining records and closes the files (called by the destructor)
+ */
+void LifetimeWriter::close()
+{
+    if (!writer.joinable()) {
+        return;
+    }
+    closing = true;
+    writer.join();
+    flushBatch();
+    std::fclose(file);
+    if (csvFile != nullptr) {
+        std::fclose(csvFile);
+    }
+}
+
+/*
+ * Names the vehicle classes in the CSV copy (car, suv and truck by default);
+ * must be called before the first submit()
+ * @param const std::vector<std::string>& names indexed by VehicleType
+ */
+void LifetimeWriter::setTypeNames(const std::vector<std::string>& names)
+{
+    typeNames = names;
+}
+
+/*
+ * @param uint8_t type VehicleType
+ * @return std::string CSV name of the class (its number if it has none)
+ */
+std::string LifetimeWriter::typeName(uint8_t type) const
+{
+    return type < typeNames.size() ? typeNames[type] : std::to_string(type);
+}
+
+/*
+ * Writer thread: moves records from the ring into the batch and writes the
+ * batch whenever it is full
+ */
+void LifetimeWriter::run()
+{
+    while (true) {
+        LifetimeRecord* record = ring.front();
+        if (record != nullptr) {
+            batch.push_back(*record);
+            ring.pop();
+            if (batch.size() == BATCH_RECORDS) {
+                flushBatch();
+            }
+        } else if (closing) {
+            // records submitted before close() are visible once closing is
+            if (ring.front() == nullptr) {
+                break;
+            }
+        } else {
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+        }
+    }
+}
+
+/*
+ * Copies one field of every record of the batch next to each other
+ * @param char*& out moved past the column
+ * @param const std::vector<LifetimeRecord>& batch
+ * @param Field LifetimeRecord::* field
+ */
+template <class Field>
+static void writeColumn(char*& out, const std::vector<LifetimeRecord>& batch, Field LifetimeRecord::* field)
+{
+    for (const LifetimeRecord& record : batch) {
+        std::memcpy(out, &(record.*field), sizeof(Field));
+        out += sizeof(Field);
+    }
+}
+
+/*
+ * Writes the batch as one column block (and as CSV lines) and empties it
+ */
+void LifetimeWriter::flushBatch()
+{
+    if (batch.empty()) {
+        return;
+    }
+
+    char* out = columns.data();
+    int32_t count = batch.size();
+    std::memcpy(out, &count, sizeof(count));
+    out += sizeof(count);
+    writeColumn(out, batch, &LifetimeRecord::id);
+    writeColumn(out, batch, &LifetimeRecord::type);
+    writeColumn(out, batch, &LifetimeRecord::bound);
+    writeColumn(out, batch, &LifetimeRecord::turn);
+    writeColumn(out, batch, &LifetimeRecord::spawnTick);
+    writeColumn(out, batch, &LifetimeRecord::entryTick);
+    writeColumn(out, batch, &LifetimeRecord::exitTick);
+    writeColumn(out, batch, &LifetimeRecord::stoppedTicks);
+    std::fwrite(columns.data(), 1, out - columns.data(), file);
+
+    if (csvFile != nullptr) {
+        char line[160];
+        for (const LifetimeRecord& record : batch) {
+            int length = std::snprintf(line, sizeof(line), "%d,%s,%s,%s,%d,%d,%d,%d\n", record.id,
+                                       typeName(record.type).c_str(), DIRECTION_NAMES[record.bound],
+                                       TURN_NAMES[record.turn], record.spawnTick, record.entryTick,
+                                       record.exitTick, record.stoppedTicks);
+            csv.append(line, length);
+        }
+        std::fwrite(csv.data(), 1, csv.size(), csvFile);
+        csv.clear();
+    }
+
+    written += batch.size();
+    batch.clear();
+}
+
+#endif
@@ -0,0 +1,90 @@
+#ifndef __LIFETIME_WRITER_H__
+#define __LIFETIME_WRITER_H__
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+#include "SpscRing.h"
+
+// What is kept of a vehicle once it has left the map
+struct LifetimeRecord {
+    int32_t id;
+    uint8_t type;           // VehicleType
+    uint8_t bound;          // Direction of travel on arrival (north: came from the south approach)
+    uint8_t turn;           // TurnType
+    int32_t spawnTick;      // joined its entry queue
+    int32_t entryTick;      // entered the intersection
+    int32_t exitTick;       // left the map
+    int32_t stoppedTicks;   // ticks on the road without moving
+};
+
+/*
+ * Writes the lifetime records of the vehicles leaving the map without slowing
+ * the simulation down. submit() copies a record into a lock-free ring; a
+ * background thread drains it into one buffer per field and writes them as a
+ * column block every BATCH_RECORDS records:
+ *
+ *   "LIFETIM1", then blocks of: int32 count, count int32 ids, count uint8
+ *   types, count uint8 bounds, count uint8 turns, then count int32 each of
+ *   spawn, entry and exit ticks and of stopped ticks (native byte order)
+ *
+ * and optionally the same records as CSV. Unlike frames, records are never
+ * dropped: when the ring is full submit() waits for the writer (counted).
+ */
+class LifetimeWriter {
+    private:
+        static const size_t BATCH_RECORDS = 1 << 16;
+
+        SpscRing<LifetimeRecord> ring;
+
+        std::FILE* file;
+        std::FILE* csvFile;
+        std::vector<LifetimeRecord> batch;      // writer thread only
+        std::vector<char> columns;
+        std::string csv;
+        std::vector<std::string> typeNames;     // CSV names, indexed by VehicleType
+
+        std::atomic<bool> closing;
+        std::atomic<long> written;
+        long waits;                             // producer only
+        std::thread writer;
+
+        void run();
+        void flushBatch();
+        std::string typeName(uint8_t type) const;
+
+    public:
+        static const char MAGIC[8];
+
+        LifetimeWriter(const std::string& path, const std::string& csvPath = "", size_t slots = 1 << 16);
+        ~LifetimeWriter();
+        LifetimeWriter(const LifetimeWriter&) = delete;
+        LifetimeWriter& operator=(const LifetimeWriter&) = delete;
+
+        /*
+         * Queues a record for the writer thread (producer thread only)
+         * @param const LifetimeRecord& record
+         */
+        inline void submit(const LifetimeRecord& record)
+        {
+            LifetimeRecord* slot = ring.beginPush();
+            while (slot == nullptr) {
+                waits++;
+                std::this_thread::yield();
+                slot = ring.beginPush();
+            }
+            *slot = record;
+            ring.commitPush();
+        }
+
+        void close();
+        void setTypeNames(const std::vector<std::string>& names);
+
+        inline long getWritten() const { return written; }
+        inline long getWaits() const { return waits; }
+};
+
+#endif
@@ -0,0 +1,89 @@
+#ifndef __OCCUPANCY_MAP_CPP__
+#define __OCCUPANCY_MAP_CPP__
+
+#include "OccupancyMap.h"
+
+#include <fstream>
+#include <stdexcept>
+
+using namespace std;
+
+static const char* DIRECTION_NAMES[] = {"north", "south", "east", "west"};
+
+/*
+ * @param int roadLen sections before the intersection (as in the configuration)
+ */
+OccupancyMap::OccupancyMap(int roadLen) : roadLen(roadLen), sections(roadLen * 2 + 2), ticks(0) {
+    clear();
+}
+
+/*
+ * Forgets everything counted so far
+ */
+void OccupancyMap::clear() {
+    ticks = 0;
+    for (int bound = 0; bound < 4; bound++) {
+        occupiedChanges[bound].assign(sections + 1, 0);
+        stoppedChanges[bound].assign(sections + 1, 0);
+    }
+}
+
+/*
+ * @param const vector<long>& changes difference array
+ * @return vector<long> count of every section
+ */
+vector<long> OccupancyMap::runningSums(const vector<long>& changes) {
+    vector<long> counts(changes.size() - 1);
+    long count = 0;
+    for (size_t i = 0; i < counts.size(); i++) {
+        count += changes[i];
+        counts[i] = count;
+    }
+    return counts;
+}
+
+/*
+ * @param Direction direction
+ * @return vector<long> ticks every section of the bound was held by a vehicle
+ */
+vector<long> OccupancyMap::getOccupied(Direction direction) const {
+    return runningSums(occupiedChanges[static_cast<int>(direction)]);
+}
+
+/*
+ * @param Direction direction
+ * @return vector<long> ticks every section of the bound was held by a stopped vehicle
+ */
+vector<long> OccupancyMap::getStopped(Direction direction) const {
+    return runningSums(stoppedChanges[static_cast<int>(direction)]);
+}
+
+/*
+ * Writes one line per bound and section:
+ * bound,section,zone,occupied_ticks,stopped_ticks,occupied_share,stopped_share
+ * (zone: approach, intersection or departure; shares are of the ticks counted)
+ * @param const string& path
+ * @throws runtime_error if the file can't be written
+ */
+void OccupancyMap::writeCsv(const string& path) const {
+    ofstream file(path);
+    if (!file) {
+        throw runtime_error("Unable to write occupancy file: " + path);
+    }
+    file << "bound,section,zone,occupied_ticks,stopped_ticks,occupied_share,stopped_share\n";
+    for (int bound = 0; bound < 4; bound++) {
+        vector<long> occupied = getOccupied(static_cast<Direction>(bound));
+        vector<long> stopped = getStopped(static_cast<Direction>(bound));
+        for (int section = 0; section < sections; section++) {
+            const char* zone = section < roadLen ? "approach" : section <= roadLen + 1 ? "intersection" : "departure";
+            file << DIRECTION_NAMES[bound] << "," << section << "," << zone << "," << occupied[section] << ","
+                 << stopped[section] << "," << (ticks > 0 ? static_cast<double>(occupied[section]) / ticks : 0)
+                 << "," << (ticks > 0 ? static_cast<double>(stopped[section]) / ticks : 0) << "\n";
+        }
+    }
+    if (!file) {
+        throw runtime_error("Unable to write occupancy file: " + path);
+    }
+}
+
+#endif
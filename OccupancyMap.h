@@ -0,0 +1,64 @@
+#ifndef __OCCUPANCY_MAP_H__
+#define __OCCUPANCY_MAP_H__
+
+#include <string>
+#include <vector>
+#include "VehicleBase.h"
+
+using namespace std;
+
+/*
+ * Heatmap of the sections of the four bounds: for every section, the ticks it
+ * was held by a vehicle and the ticks it was held by a stopped vehicle. The
+ * simulator reports each span a vehicle paints (first ... last) as it paints
+ * it, and the map records it as two entries of a difference array, so a tick
+ * costs two additions per vehicle whatever the road length; the counts per
+ * section are the running sums, computed once when the heatmap is read.
+ * Sections roadLen and roadLen + 1 of every bound are the intersection (each
+ * of its four cells is crossed by two bounds). The map keeps counting across
+ * resets of the simulator, so replications add up.
+ */
+class OccupancyMap {
+    private:
+        int roadLen;
+        int sections;                   // per bound, as in the lanes
+        long ticks;
+        vector<long> occupiedChanges[4];    // difference arrays, indexed by Direction
+        vector<long> stoppedChanges[4];
+
+        // Adds one tick to sections first ... last of a difference array (none if first > last)
+        inline void record(vector<long>& changes, int first, int last) {
+            first = first < 0 ? 0 : first;
+            last = last >= sections ? sections - 1 : last;
+            if (first <= last) {
+                changes[first]++;
+                changes[last + 1]--;
+            }
+        }
+
+        static vector<long> runningSums(const vector<long>& changes);
+
+    public:
+        OccupancyMap(int roadLen);
+
+        inline void addOccupied(Direction direction, int first, int last) {
+            record(occupiedChanges[static_cast<int>(direction)], first, last);
+        }
+        inline void addStopped(Direction direction, int first, int last) {
+            record(stoppedChanges[static_cast<int>(direction)], first, last);
+        }
+        inline void addTick() { ticks++; }
+        void clear();
+
+        // Ticks every section of a bound was held (by a stopped vehicle)
+        vector<long> getOccupied(Direction direction) const;
+        vector<long> getStopped(Direction direction) const;
+
+        void writeCsv(const string& path) const;
+
+        inline int getRoadLen() const { return roadLen; }
+        inline int getSections() const { return sections; }
+        inline long getTicks() const { return ticks; }
+};
+
+#endif
@@ -0,0 +1,291 @@
+#include "Simulator.h"
+#include "SampleStatistics.h"
+
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <stdexcept>
+#include <thread>
+
+using namespace std;
+
+// Light durations searched, in this order
+static const int TIMINGS = 4;
+static const char* TIMING_NAMES[TIMINGS] = {"green_north_south", "yellow_north_south",
+                                            "green_east_west", "yellow_east_west"};
+
+typedef array<int, TIMINGS> Timing;
+
+static void printUsage() {
+    cerr << "Usage: ./OptimizeSignals [config_file] [first_seed] [options]" << endl;
+    cerr << "Searches the green and yellow durations that minimize travel time or entry queues" << endl;
+    cerr << "(or maximize throughput), starting from the durations of the configuration" << endl;
+    cerr << "  --kpi NAME           queue (default), delay, travel_time or throughput" << endl;
+    cerr << "  --replications R     seeds first_seed .. first_seed+R-1 per candidate (default 10)" << endl;
+    cerr << "  --step S             initial change of a duration, halved down to 1 (default 8)" << endl;
+    cerr << "  --threads N          candidates evaluated at the same time (default: all cores)" << endl;
+    cerr << "  --min-yellow Y       shortest yellow tried (default 1)" << endl;
+    cerr << "  --fixed-yellow       only search the green durations" << endl;
+    cerr << "  --max-evaluations N  budget of candidates (default 200)" << endl;
+}
+
+// Result of one candidate over the replications it ran
+struct Evaluation {
+    Timing timing;
+    double objective;       // mean over the replications run, lower is better
+    int replications;
+    bool rejected;          // stopped early: clearly worse than the incumbent
+    bool stalled;           // a replication froze the intersection (stall_ticks)
+    vector<double> values;  // objective for every seed run
+};
+
+/*
+ * Evaluates candidates over common seeds and paired random streams, so that
+ * a difference between two timings isn't hidden by different arrivals
+ */
+class SignalSearch {
+    private:
+        map<string, double> parameters;
+        int firstSeed;
+        int replications;
+        Kpi kpi;
+        double sign;                        // -1 when the measure is maximized
+        vector<unique_ptr<Simulator>> simulators;   // one per thread, reused for every candidate
+
+        vector<double> incumbentValues;     // objective of the incumbent for every seed
+        bool incumbentStalled;              // then any timing that doesn't stall is better
+        map<Timing, Evaluation> evaluated;
+
+    public:
+        SignalSearch(const SimConfig& config, int firstSeed, int replications, Kpi kpi, int threads)
+                : parameters(config.getParameters()), firstSeed(firstSeed), replications(replications),
+                  kpi(kpi), sign(kpi == Kpi::throughput ? -1 : 1), incumbentStalled(false) {
+            parameters["paired_random_streams"] = 1;
+            SimConfig paired = SimConfig::fromParameters(parameters);
+            for (int t = 0; t < threads; t++) {
+                simulators.emplace_back(new Simulator(paired, firstSeed));
+            }
+        }
+
+        /*
+         * @param const Timing& timing
+         * @return SimConfig the base configuration with these light durations
+         * @throws runtime_error if the durations are invalid
+         */
+        SimConfig configFor(const Timing& timing) const {
+            map<string, double> candidate = parameters;
+            for (int i = 0; i < TIMINGS; i++) {
+                candidate[TIMING_NAMES[i]] = timing[i];
+            }
+            return SimConfig::fromParameters(candidate);
+        }
+
+        /*
+         * Runs the replications of one candidate, stopping as soon as the paired
+         * differences with the incumbent show it is worse (95% confidence)
+         * @param Simulator& sim simulator owned by the calling thread
+         * @param const Timing& timing
+         * @param bool allowRejection false for the incumbent itself
+         */
+        Evaluation evaluate(Simulator& sim, const Timing& timing, bool allowRejection) const {
+            sim.setConfig(configFor(timing));
+            Evaluation result{timing, 0, 0, false, false, {}};
+            SampleStatistics objective;
+            SampleStatistics difference;
+            while (result.replications < replications && !result.rejected) {
+                int r = result.replications++;
+                sim.reset(firstSeed + r);
+                sim.step(sim.getConfig().simTime);
+                double value = sign * sim.getStatistics().getKpi(kpi);
+                objective.add(value);
+                result.values.push_back(value);
+                if (sim.isStalled()) {
+                    // the measures of an aborted run mean nothing: never an improvement
+                    result.stalled = true;
+                    result.rejected = allowRejection;
+                } else if (allowRejection && !incumbentStalled) {
+                    difference.add(value - incumbentValues[r]);
+                    result.rejected = difference.getCount() >= 3 &&
+                                      difference.getMean() - difference.getHalfWidth() > 0;
+                }
+            }
+            result.objective = objective.getMean();
+            return result;
+        }
+
+        /*
+         * Makes a timing the incumbent, evaluating it on every seed
+         * @param const Timing& timing
+         * @return const Evaluation&
+         */
+        const Evaluation& setIncumbent(const Timing& timing) {
+            auto found = evaluated.find(timing);
+            if (found == evaluated.end() || found->second.rejected) {
+                evaluated[timing] = evaluate(*simulators[0], timing, false);
+            }
+            incumbentValues = evaluated[timing].values;
+            incumbentStalled = evaluated[timing].stalled;
+            return evaluated[timing];
+        }
+
+        /*
+         * Evaluates the candidates not seen before, spread over the threads
+         * @param const vector<Timing>& candidates
+         * @return vector<Evaluation> one per candidate, in the same order
+         */
+        vector<Evaluation> evaluateAll(const vector<Timing>& candidates) {
+            vector<Timing> pending;
+            for (const Timing& timing : candidates) {
+                if (evaluated.find(timing) == evaluated.end()) {
+                    pending.push_back(timing);
+                }
+            }
+
+            vector<Evaluation> results(pending.size());
+            atomic<int> next(0);
+            auto work = [&](Simulator* sim) {
+                for (int c = next++; c < static_cast<int>(pending.size()); c = next++) {
+                    results[c] = evaluate(*sim, pending[c], true);
+                }
+            };
+            vector<thread> workers;
+            int threads = min(simulators.size(), pending.size());
+            for (int t = 1; t < threads; t++) {
+                workers.emplace_back(work, simulators[t].get());
+            }
+            work(simulators[0].get());
+            for (thread& worker : workers) {
+                worker.join();
+            }
+
+            for (const Evaluation& result : results) {
+                evaluated[result.timing] = result;
+            }
+            vector<Evaluation> all;
+            for (const Timing& timing : candidates) {
+                all.push_back(evaluated[timing]);
+            }
+            return all;
+        }
+
+        inline int getEvaluationCount() const { return evaluated.size(); }
+        inline double getSign() const { return sign; }
+};
+
+/*
+ * @param const Timing& timing
+ * @return string e.g. "green 30/24, yellow 4/4"
+ */
+static string describe(const Timing& timing) {
+    return "green " + to_string(timing[0]) + "/" + to_string(timing[2]) +
+           ", yellow " + to_string(timing[1]) + "/" + to_string(timing[3]);
+}
+
+int main(int argc, char* argv[]) {
+
+    if (argc < 3) {
+        printUsage();
+        exit(0);
+    }
+
+    try {
+        SimConfig config = SimConfig::fromFile(argv[1]);
+        int firstSeed = stoi(argv[2]);
+        // delay and travel time only count the vehicles that left the map, so it rewards
+        // starving one direction: entry queues are the safer default
+        Kpi kpi = Kpi::queueLength;
+        int replications = 10;
+        int step = 8;
+        int threads = max(1u, thread::hardware_concurrency());
+        int minYellow = 1;
+        bool fixedYellow = false;
+        int maxEvaluations = 200;
+
+        for (int a = 3; a < argc; a++) {
+            string option = argv[a];
+            if (option == "--fixed-yellow") {
+                fixedYellow = true;
+                continue;
+            }
+            if (a + 1 >= argc) {
+                throw runtime_error("Missing value for " + option);
+            }
+            string value = argv[++a];
+            if (option == "--kpi") {
+                kpi = RunStatistics::kpiFromName(value);
+            } else if (option == "--replications") {
+                replications = stoi(value);
+            } else if (option == "--step") {
+                step = stoi(value);
+            } else if (option == "--threads") {
+                threads = stoi(value);
+            } else if (option == "--min-yellow") {
+                minYellow = stoi(value);
+            } else if (option == "--max-evaluations") {
+                maxEvaluations = stoi(value);
+            } else {
+                throw runtime_error("Unknown option: " + option);
+            }
+        }
+        if (replications < 3 || step < 1 || threads < 1 || minYellow < 0) {
+            throw runtime_error("--replications must be at least 3, --step and --threads at least 1");
+        }
+
+        SignalSearch search(config, firstSeed, replications, kpi, threads);
+        Timing best = {config.greenNS, config.yellowNS, config.greenEW, config.yellowEW};
+        Evaluation incumbent = search.setIncumbent(best);
+        double sign = search.getSign();
+        printf("start        %-28s %s %.4f%s\n", describe(best).c_str(),
+               RunStatistics::kpiName(kpi).c_str(), sign * incumbent.objective,
+               incumbent.stalled ? " (stalls, any timing that doesn't is better)" : "");
+
+        // coordinate search: try every duration one step up and down, move to
+        // the best improvement, halve the step when none improves
+        while (step >= 1 && search.getEvaluationCount() < maxEvaluations) {
+            vector<Timing> candidates;
+            for (int i = 0; i < TIMINGS; i++) {
+                bool yellow = (i % 2 == 1);
+                if (yellow && fixedYellow) {
+                    continue;
+                }
+                for (int direction = -1; direction <= 1; direction += 2) {
+                    Timing candidate = best;
+                    candidate[i] += direction * step;
+                    if (candidate[i] >= (yellow ? minYellow : 1)) {
+                        candidates.push_back(candidate);
+                    }
+                }
+            }
+
+            vector<Evaluation> results = search.evaluateAll(candidates);
+            const Evaluation* improvement = nullptr;
+            int rejected = 0;
+            for (const Evaluation& result : results) {
+                rejected += result.rejected ? 1 : 0;
+                if (!result.rejected && (incumbent.stalled || result.objective < incumbent.objective) &&
+                    (improvement == nullptr || result.objective < improvement->objective)) {
+                    improvement = &result;
+                }
+            }
+
+            if (improvement != nullptr) {
+                best = improvement->timing;
+                incumbent = search.setIncumbent(best);
+                printf("step %-7d %-28s %s %.4f (%d of %d candidates stopped early)\n", step, describe(best).c_str(),
+                       RunStatistics::kpiName(kpi).c_str(), sign * incumbent.objective, rejected,
+                       static_cast<int>(results.size()));
+            } else {
+                step /= 2;
+            }
+        }
+
+        cout << endl << search.getEvaluationCount() << " candidates evaluated on " << replications
+             << " seeds; best durations:" << endl;
+        for (int i = 0; i < TIMINGS; i++) {
+            cout << TIMING_NAMES[i] << " " << best[i] << endl;
+        }
+    } catch (const exception& e) {
+        cerr << e.what() << endl;
+        return 2;
+    }
+}
@@ -0,0 +1,346 @@
+#ifndef __REPLAY_FILE_CPP__
+#define __REPLAY_FILE_CPP__
+
+#include "ReplayFile.h"
+#include "Simulator.h"
+
+#include <cstring>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+const char ReplayRecorder::MAGIC[8] = {'R', 'E', 'P', 'L', 'A', 'Y', '0', '2'};
+const char ReplayRecorder::INDEX_MAGIC[8] = {'R', 'E', 'P', 'L', 'A', 'Y', 'I', 'X'};
+
+// Bytes of the end of the file after the keyframe offsets
+static const size_t TRAILER_BYTES = 3 * sizeof(int32_t) + sizeof(int64_t) + sizeof(ReplayRecorder::INDEX_MAGIC);
+
+// Bytes of one changed section in a delta frame
+static const size_t CHANGE_BYTES = sizeof(uint8_t) + sizeof(int32_t) + sizeof(int64_t);
+
+/*
+ * Appends a value to a buffer in native byte order
+ * @param vector<char>& buffer
+ * @param T value
+ */
+template <class T>
+static void append(vector<char>& buffer, T value) {
+    const char* bytes = reinterpret_cast<const char*>(&value);
+    buffer.insert(buffer.end(), bytes, bytes + sizeof(T));
+}
+
+/*
+ * Reads a value stored in native byte order at any alignment
+ * @param const char* bytes
+ * @return T
+ */
+template <class T>
+static T load(const char* bytes) {
+    T value;
+    memcpy(&value, bytes, sizeof(T));
+    return value;
+}
+
+/*
+ * Creates the file and writes the header
+ * @param const string& path
+ * @param int roadLen sections before the intersection
+ * @param int keyframeInterval frames from one full frame to the next
+ * @throws runtime_error if the file can't be created or the interval is below 1
+ */
+ReplayRecorder::ReplayRecorder(const string& path, int roadLen, int keyframeInterval)
+        : file(nullptr), roadLen(roadLen), sections(roadLen * 2 + 2), keyframeInterval(keyframeInterval),
+          firstTick(0), frames(0), offset(0) {
+    if (keyframeInterval < 1) {
+        throw runtime_error("The keyframe interval must be at least 1");
+    }
+    file = fopen(path.c_str(), "wb");
+    if (file == nullptr) {
+        throw runtime_error("Unable to open replay file: " + path);
+    }
+    for (vector<int64_t>& lane : cells) {
+        lane.assign(sections, -1);
+    }
+    scratch.resize(sections);
+    write(MAGIC, sizeof(MAGIC));
+    write(&roadLen, sizeof(roadLen));
+    write(&keyframeInterval, sizeof(keyframeInterval));
+}
+
+ReplayRecorder::~ReplayRecorder() {
+    try {
+        close();
+    } catch (const exception&) {
+        // nothing can be reported from a destructor: call close() to know
+    }
+}
+
+/*
+ * @param const void* bytes
+ * @param size_t count
+ * @throws runtime_error if the file can't be written
+ */
+void ReplayRecorder::write(const void* bytes, size_t count) {
+    if (fwrite(bytes, 1, count, file) != count) {
+        throw runtime_error("Unable to write the replay file");
+    }
+    offset += count;
+}
+
+/*
+ * @param const VehicleBase* vehicle nullptr for an empty section
+ * @return int64_t code of a section held by the vehicle
+ */
+int64_t ReplayRecorder::encode(const VehicleBase* vehicle) {
+    if (vehicle == nullptr) {
+        return -1;
+    }
+    return static_cast<int64_t>(vehicle->getVehicleID()) * 64 + static_cast<int>(vehicle->getVehicleType()) * 4
+           + static_cast<int>(vehicle->getVehicleOriginalDirection());
+}
+
+/*
+ * Records the state after the tick the simulator just ran. Ticks must be
+ * recorded one after the other.
+ * @param const Simulator& sim
+ * @throws runtime_error if a tick was skipped or the file can't be written
+ */
+void ReplayRecorder::record(const Simulator& sim) {
+    int tick = sim.getTime() - 1;
+    if (frames == 0) {
+        firstTick = tick;
+    } else if (tick != firstTick + frames) {
+        throw runtime_error("Replay frames must be recorded every tick");
+    }
+    if (sim.getConfig().roadLen != roadLen) {
+        throw runtime_error("Replay recorder built for another road length");
+    }
+
+    bool keyframe = frames % keyframeInterval == 0;
+    buffer.clear();
+    append<uint8_t>(buffer, keyframe ? 1 : 0);
+    append<uint8_t>(buffer, static_cast<int>(sim.getLightNorthSouth()) | static_cast<int>(sim.getLightEastWest()) << 2);
+    size_t countAt = buffer.size();
+    if (!keyframe) {
+        append<int32_t>(buffer, 0);
+    }
+
+    int32_t changes = 0;
+    for (int bound = 0; bound < 4; bound++) {
+        sim.getLane(static_cast<Direction>(bound)).copyRange(0, sections - 1, scratch.data());
+        vector<int64_t>& lane = cells[bound];
+        for (int section = 0; section < sections; section++) {
+            int64_t code = encode(scratch[section]);
+            if (keyframe) {
+                append<int64_t>(buffer, code);
+            } else if (code != lane[section]) {
+                append<uint8_t>(buffer, bound);
+                append<int32_t>(buffer, section);
+                append<int64_t>(buffer, code);
+                changes++;
+            }
+            lane[section] = code;
+        }
+    }
+    if (!keyframe) {
+        memcpy(buffer.data() + countAt, &changes, sizeof(changes));
+    } else {
+        keyframes.push_back(offset);
+    }
+    write(buffer.data(), buffer.size());
+    frames++;
+}
+
+/*
+ * Writes the index and closes the file (called by the destructor)
+ * @throws runtime_error if the file can't be written
+ */
+void ReplayRecorder::close() {
+    if (file == nullptr) {
+        return;
+    }
+    int64_t indexOffset = offset;
+    int32_t keyframeCount = keyframes.size();
+    try {
+        write(keyframes.data(), keyframes.size() * sizeof(int64_t));
+        write(&firstTick, sizeof(firstTick));
+        write(&frames, sizeof(frames));
+        write(&keyframeCount, sizeof(keyframeCount));
+        write(&indexOffset, sizeof(indexOffset));
+        write(INDEX_MAGIC, sizeof(INDEX_MAGIC));
+    } catch (const exception&) {
+        fclose(file);
+        file = nullptr;
+        throw;
+    }
+    bool failed = fclose(file) != 0;
+    file = nullptr;
+    if (failed) {
+        throw runtime_error("Unable to write the replay file");
+    }
+}
+
+/*
+ * Maps a recording and reads its index
+ * @param const string& path
+ * @throws runtime_error if the file can't be read or isn't a complete
+ * recording of at least one tick
+ */
+ReplayPlayer::ReplayPlayer(const string& path)
+        : data(nullptr), length(0), tick(0), next(0), northSouth(LightColor::green), eastWest(LightColor::red) {
+    int descriptor = ::open(path.c_str(), O_RDONLY);
+    if (descriptor < 0) {
+        throw runtime_error("Unable to open file: " + path);
+    }
+    struct stat status;
+    if (fstat(descriptor, &status) != 0) {
+        ::close(descriptor);
+        throw runtime_error("Unable to read file: " + path);
+    }
+    length = status.st_size;
+    size_t header = sizeof(ReplayRecorder::MAGIC) + 2 * sizeof(int32_t);
+    if (length < header + TRAILER_BYTES) {
+        ::close(descriptor);
+        throw runtime_error("Not a complete replay file: " + path);
+    }
+    void* mapped = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, descriptor, 0);
+    // the mapping stays valid after the descriptor is closed
+    ::close(descriptor);
+    if (mapped == MAP_FAILED) {
+        throw runtime_error("Unable to map file: " + path);
+    }
+    data = static_cast<const char*>(mapped);
+
+    const char* trailer = data + length - TRAILER_BYTES;
+    int keyframeCount = load<int32_t>(trailer + 2 * sizeof(int32_t));
+    int64_t indexOffset = load<int64_t>(trailer + 3 * sizeof(int32_t));
+    if (memcmp(data, ReplayRecorder::MAGIC, sizeof(ReplayRecorder::MAGIC)) != 0 ||
+            memcmp(data + length - sizeof(ReplayRecorder::INDEX_MAGIC), ReplayRecorder::INDEX_MAGIC,
+                   sizeof(ReplayRecorder::INDEX_MAGIC)) != 0 ||
+            keyframeCount < 0 || indexOffset < static_cast<int64_t>(header) ||
+            indexOffset + keyframeCount * sizeof(int64_t) + TRAILER_BYTES != length) {
+        munmap(const_cast<char*>(data), length);
+        throw runtime_error("Not a complete replay file: " + path);
+    }
+    roadLen = load<int32_t>(data + sizeof(ReplayRecorder::MAGIC));
+    keyframeInterval = load<int32_t>(data + sizeof(ReplayRecorder::MAGIC) + sizeof(int32_t));
+    firstTick = load<int32_t>(trailer);
+    frames = load<int32_t>(trailer + sizeof(int32_t));
+
+    // a damaged header must not size the lanes or divide by zero in seek(),
+    // and every keyframe of the index must be a whole keyframe of the file
+    int64_t keyframeBytes = 2 + 4 * (static_cast<int64_t>(roadLen) * 2 + 2) * sizeof(int64_t);
+    bool valid = roadLen >= 3 && keyframeInterval >= 1 && frames >= 1 &&
+                 keyframeCount == (frames - 1) / keyframeInterval + 1;
+    for (int k = 0; valid && k < keyframeCount; k++) {
+        int64_t keyframe = load<int64_t>(data + indexOffset + k * sizeof(int64_t));
+        valid = keyframe >= static_cast<int64_t>(header) && keyframe <= indexOffset - keyframeBytes &&
+                data[keyframe] == 1;
+        keyframes.push_back(keyframe);
+    }
+    if (!valid) {
+        munmap(const_cast<char*>(data), length);
+        throw runtime_error("Damaged replay file (header or index): " + path);
+    }
+    sections = roadLen * 2 + 2;
+
+    for (int bound = 0; bound < 4; bound++) {
+        vehicles[bound].assign(sections, VehicleBase(VehicleType::car, Direction::north, -1));
+        lanes[bound].assign(sections, nullptr);
+    }
+    tick = firstTick - 1;
+}
+
+ReplayPlayer::~ReplayPlayer() {
+    munmap(const_cast<char*>(data), length);
+}
+
+/*
+ * @param int bound
+ * @param int section
+ * @param int64_t code section code (-1 when empty)
+ */
+void ReplayPlayer::setSection(int bound, int section, int64_t code) {
+    if (code < 0) {
+        lanes[bound][section] = nullptr;
+        return;
+    }
+    vehicles[bound][section] = VehicleBase(static_cast<VehicleType>((code >> 2) & 15),
+                                           static_cast<Direction>(code & 3), code >> 6);
+    lanes[bound][section] = &vehicles[bound][section];
+}
+
+/*
+ * Applies the frame at a position to the lanes and lights shown
+ * @param size_t position
+ * @return size_t position of the next frame
+ * @throws runtime_error if the frame is damaged
+ */
+size_t ReplayPlayer::readFrame(size_t position) {
+    const size_t end = length - TRAILER_BYTES - keyframes.size() * sizeof(int64_t);
+    if (position + 2 > end) {
+        throw runtime_error("Damaged replay file");
+    }
+    bool keyframe = data[position] == 1;
+    int lights = static_cast<uint8_t>(data[position + 1]);
+    northSouth = static_cast<LightColor>(lights & 3);
+    eastWest = static_cast<LightColor>(lights >> 2);
+    position += 2;
+
+    if (keyframe) {
+        if (position + 4 * sections * sizeof(int64_t) > end) {
+            throw runtime_error("Damaged replay file");
+        }
+        for (int bound = 0; bound < 4; bound++) {
+            for (int section = 0; section < sections; section++) {
+                setSection(bound, section, load<int64_t>(data + position));
+                position += sizeof(int64_t);
+            }
+        }
+        return position;
+    }
+
+    int changes = position + sizeof(int32_t) <= end ? load<int32_t>(data + position) : -1;
+    position += sizeof(int32_t);
+    if (changes < 0 || position + changes * CHANGE_BYTES > end) {
+        throw runtime_error("Damaged replay file");
+    }
+    for (int c = 0; c < changes; c++) {
+        int bound = static_cast<uint8_t>(data[position]);
+        int section = load<int32_t>(data + position + 1);
+        if (bound > 3 || section < 0 || section >= sections) {
+            throw runtime_error("Damaged replay file");
+        }
+        setSection(bound, section, load<int64_t>(data + position + 5));
+        position += CHANGE_BYTES;
+    }
+    return position;
+}
+
+/*
+ * Shows a tick: a later tick after the same keyframe is reached from the
+ * tick shown, any other one is rebuilt from the keyframe before it
+ * @param int tick between getFirstTick() and getLastTick()
+ * @throws out_of_range if the tick wasn't recorded
+ */
+void ReplayPlayer::seek(int tick) {
+    if (tick < firstTick || tick >= firstTick + frames) {
+        throw out_of_range("Tick " + to_string(tick) + " is not in the recording");
+    }
+    int frame = tick - firstTick;
+    int shown = this->tick - firstTick;
+    if (shown < 0 || frame < shown || frame / keyframeInterval != shown / keyframeInterval) {
+        next = keyframes[frame / keyframeInterval];
+        this->tick = firstTick + frame / keyframeInterval * keyframeInterval - 1;
+    }
+    while (this->tick < tick) {
+        next = readFrame(next);
+        this->tick++;
+    }
+}
+
+#endif
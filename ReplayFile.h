@@ -0,0 +1,112 @@
+#ifndef __REPLAY_FILE_H__
+#define __REPLAY_FILE_H__
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "RoadLanes.h"
+#include "VehicleBase.h"
+
+using namespace std;
+
+class Simulator;
+
+/*
+ * Recorded run that can be shown from any tick. Every frame holds what the
+ * Animator draws: the two lights and, per section of each bound, the ID,
+ * type and original direction of the vehicle holding it. One frame in every
+ * keyframe interval is stored in full, the others as the sections that
+ * changed since the frame before, so showing a tick costs one keyframe and
+ * at most interval - 1 deltas, wherever it is in the run:
+ *
+ *   "REPLAY02", int32 roadLen, int32 keyframe interval, then frames of:
+ *     uint8 kind (1 keyframe, 0 delta), uint8 lights (north-south | east-west << 2)
+ *     keyframe: int64 section codes of the north, south, east, west bounds
+ *     delta: int32 count, then count times uint8 bound, int32 section, int64 code
+ *   then the index: int64 offset of every keyframe, int32 first tick,
+ *   int32 frames, int32 keyframes, int64 offset of the index, "REPLAYIX"
+ *
+ * A section code is -1 when empty, else id * 64 + type * 4 + direction, room
+ * for SimConfig::MAX_VEHICLE_CLASSES types (native byte order).
+ */
+class ReplayRecorder {
+    private:
+        FILE* file;
+        int roadLen;
+        int sections;
+        int keyframeInterval;
+        int firstTick;
+        int frames;
+        int64_t offset;                 // bytes written so far
+        vector<int64_t> cells[4];       // codes of the last frame, indexed by Direction
+        vector<int64_t> keyframes;      // offsets
+        vector<char> buffer;            // frame being encoded
+        vector<VehicleBase*> scratch;   // sections of the bound being compared
+
+        void write(const void* bytes, size_t count);
+
+    public:
+        static const char MAGIC[8];
+        static const char INDEX_MAGIC[8];
+
+        ReplayRecorder(const string& path, int roadLen, int keyframeInterval = 1000);
+        ~ReplayRecorder();
+        ReplayRecorder(const ReplayRecorder&) = delete;
+        ReplayRecorder& operator=(const ReplayRecorder&) = delete;
+
+        void record(const Simulator& sim);
+        void close();
+
+        static int64_t encode(const VehicleBase* vehicle);
+
+        inline int getFrames() const { return frames; }
+};
+
+/*
+ * Reads a recording made by ReplayRecorder (memory-mapped) and rebuilds the
+ * lanes of any tick for the Animator
+ */
+class ReplayPlayer {
+    private:
+        const char* data;
+        size_t length;
+        int roadLen;
+        int sections;
+        int keyframeInterval;
+        int firstTick;
+        int frames;
+        vector<int64_t> keyframes;
+
+        int tick;                       // tick shown, firstTick - 1 before the first seek
+        size_t next;                    // offset of the frame after it
+        LightColor northSouth;
+        LightColor eastWest;
+        vector<VehicleBase> vehicles[4];        // one per section, indexed by Direction
+        vector<VehicleBase*> lanes[4];          // nullptr for empty sections
+
+        void setSection(int bound, int section, int64_t code);
+        size_t readFrame(size_t position);
+
+    public:
+        explicit ReplayPlayer(const string& path);
+        ~ReplayPlayer();
+        ReplayPlayer(const ReplayPlayer&) = delete;
+        ReplayPlayer& operator=(const ReplayPlayer&) = delete;
+
+        void seek(int tick);
+
+        inline LaneView getLane(Direction direction) const {
+            const vector<VehicleBase*>& lane = lanes[static_cast<int>(direction)];
+            return LaneView(lane.data(), lane.size());
+        }
+        inline LightColor getLightNorthSouth() const { return northSouth; }
+        inline LightColor getLightEastWest() const { return eastWest; }
+        inline int getTick() const { return tick; }
+        inline int getFirstTick() const { return firstTick; }
+        inline int getLastTick() const { return firstTick + frames - 1; }
+        inline int getRoadLen() const { return roadLen; }
+        inline int getKeyframeInterval() const { return keyframeInterval; }
+};
+
+#endif
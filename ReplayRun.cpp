@@ -0,0 +1,97 @@
+#include "Animator.h"
+#include "ReplayFile.h"
+
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+static void printUsage() {
+    cerr << "Usage: ./ReplayRun [replay_file] [options]" << endl;
+    cerr << "Shows a run recorded with RunSimulation --record, from any tick" << endl;
+    cerr << "  --tick T             tick shown first (default: the first one)" << endl;
+    cerr << "  --frame T            print the frame of tick T and exit" << endl;
+    cerr << "  --viewport N         draw only N sections on each side of the intersection" << endl;
+    cerr << "  --density-blocks M   draw the rest of each half lane as M occupancy blocks (default 8)" << endl;
+    cerr << "Keys (then Enter): nothing or n: next tick, b: previous tick, a number: that tick," << endl;
+    cerr << "+N / -N: N ticks forward / back, q: quit" << endl;
+}
+
+/*
+ * @param ReplayPlayer& player
+ * @param Animator& anim
+ * @return string frame of the tick shown by the player
+ */
+static string render(ReplayPlayer& player, Animator& anim) {
+    anim.setLightNorthSouth(player.getLightNorthSouth());
+    anim.setLightEastWest(player.getLightEastWest());
+    anim.setVehiclesNorthbound(player.getLane(Direction::north));
+    anim.setVehiclesWestbound(player.getLane(Direction::west));
+    anim.setVehiclesSouthbound(player.getLane(Direction::south));
+    anim.setVehiclesEastbound(player.getLane(Direction::east));
+    return anim.render(player.getTick());
+}
+
+int main(int argc, char* argv[]) {
+
+    if (argc < 2) {
+        printUsage();
+        exit(0);
+    }
+
+    try {
+        ReplayPlayer player(argv[1]);
+        int tick = player.getFirstTick();
+        bool single = false;
+        int viewport = 0;
+        int densityBlocks = 8;
+
+        for (int a = 2; a < argc; a++) {
+            string option = argv[a];
+            if (option == "--tick" && a + 1 < argc) {
+                tick = stoi(argv[++a]);
+            } else if (option == "--frame" && a + 1 < argc) {
+                tick = stoi(argv[++a]);
+                single = true;
+            } else if (option == "--viewport" && a + 1 < argc) {
+                viewport = stoi(argv[++a]);
+            } else if (option == "--density-blocks" && a + 1 < argc) {
+                densityBlocks = stoi(argv[++a]);
+            } else {
+                throw runtime_error("Unknown or incomplete option: " + option);
+            }
+        }
+
+        Animator anim(player.getRoadLen(), viewport, densityBlocks);
+        player.seek(tick);
+        cout << render(player, anim) << flush;
+        if (single) {
+            return 0;
+        }
+
+        string command;
+        while (getline(cin, command)) {
+            int target = player.getTick();
+            if (command == "q") {
+                break;
+            } else if (command.empty() || command == "n") {
+                target++;
+            } else if (command == "b") {
+                target--;
+            } else if (command[0] == '+' || command[0] == '-') {
+                target += stoi(command);
+            } else {
+                target = stoi(command);
+            }
+
+            // stay on the first or last tick rather than leaving the recording
+            target = max(player.getFirstTick(), min(player.getLastTick(), target));
+            player.seek(target);
+            cout << render(player, anim) << flush;
+        }
+    } catch (const exception& e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+}
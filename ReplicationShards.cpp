@@ -0,0 +1,191 @@
+#ifndef __REPLICATION_SHARDS_CPP__
+#define __REPLICATION_SHARDS_CPP__
+
+#include "ReplicationShards.h"
+#include "Simulator.h"
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <new>
+#include <stdexcept>
+#include <thread>
+#include <csignal>
+#include <sys/mman.h>
+#include <sys/prctl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace std;
+
+/*
+ * @param int processes
+ * @return size_t bytes of the shared block holding one channel per process
+ */
+size_t ReplicationShards::bytesFor(int processes) {
+    return sizeof(Shared) + (processes - 1) * sizeof(Channel);
+}
+
+/*
+ * Maps the shared block and starts the worker processes
+ * @param const SimConfig& config
+ * @param int firstSeed seed of replication 0
+ * @param int processes number of worker processes (at least 1)
+ * @param int maximum replications run at most
+ * @param const ResultCache* cache stored runs to reuse (none if nullptr)
+ * @throws runtime_error if the memory can't be mapped or a process can't be started
+ */
+ReplicationShards::ReplicationShards(const SimConfig& config, int firstSeed, int processes, int maximum,
+                                     const ResultCache* cache)
+        : shared(nullptr), sharedBytes(bytesFor(processes)), processes(processes), maximum(maximum), delivered(0) {
+    if (processes < 1) {
+        throw runtime_error("At least one process is needed");
+    }
+    void* memory = mmap(nullptr, sharedBytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED) {
+        throw runtime_error("Unable to map shared memory for the workers");
+    }
+    shared = static_cast<Shared*>(memory);
+    new (&shared->stopping) atomic<int>(0);
+    for (int k = 0; k < processes; k++) {
+        Channel& channel = shared->channels[k];
+        new (&channel.head) atomic<long>(0);
+        new (&channel.tail) atomic<long>(0);
+        new (&channel.failed) atomic<int>(0);
+    }
+
+    // buffered output would otherwise be written again by every worker
+    cout.flush();
+    cerr.flush();
+    pid_t parent = getpid();
+    for (int k = 0; k < processes; k++) {
+        pid_t pid = fork();
+        if (pid < 0) {
+            stop();
+            munmap(shared, sharedBytes);
+            throw runtime_error("Unable to start a worker process");
+        }
+        if (pid == 0) {
+            // a worker must not outlive the parent (it would wait for a free slot forever)
+            prctl(PR_SET_PDEATHSIG, SIGKILL);
+            if (getppid() != parent) {
+                _exit(1);
+            }
+            work(k, config, firstSeed, cache);
+        }
+        workers.push_back(pid);
+    }
+}
+
+ReplicationShards::~ReplicationShards() {
+    stop();
+    munmap(shared, sharedBytes);
+}
+
+/*
+ * Worker process: runs its replications and never returns
+ * @param int shard index of the worker
+ * @param const SimConfig& config
+ * @param int firstSeed
+ * @param const ResultCache* cache
+ */
+void ReplicationShards::work(int shard, const SimConfig& config, int firstSeed, const ResultCache* cache) {
+    Channel& channel = shared->channels[shard];
+    try {
+        Simulator sim(config, firstSeed);
+        for (int r = shard; r < maximum && !shared->stopping; r += processes) {
+            RunStatistics statistics;
+            if (cache != nullptr) {
+                statistics = cache->run(sim, firstSeed + r);
+            } else {
+                sim.reset(firstSeed + r);
+                sim.step(config.simTime);
+                statistics = sim.getStatistics();
+            }
+
+            // wait for a free slot (the parent reads in replication order)
+            long tail = channel.tail.load(memory_order_relaxed);
+            while (tail - channel.head.load(memory_order_acquire) == CHANNEL_SLOTS) {
+                if (shared->stopping) {
+                    _exit(0);
+                }
+                this_thread::sleep_for(chrono::microseconds(100));
+            }
+            channel.slots[tail % CHANNEL_SLOTS] = statistics;
+            channel.tail.store(tail + 1, memory_order_release);
+        }
+    } catch (const exception& e) {
+        strncpy(channel.message, e.what(), MESSAGE_BYTES - 1);
+        channel.message[MESSAGE_BYTES - 1] = '\0';
+        channel.failed.store(1, memory_order_release);
+        _exit(1);
+    }
+    _exit(0);
+}
+
+/*
+ * @param int status from waitpid()
+ * @return string how a worker process ended
+ */
+static string describeExit(int status) {
+    if (WIFSIGNALED(status)) {
+        return "killed by signal " + to_string(WTERMSIG(status));
+    }
+    return "exited with status " + to_string(WEXITSTATUS(status));
+}
+
+/*
+ * Waits for the statistics of the next replication, in replication order
+ * @return RunStatistics
+ * @throws runtime_error past the maximum, or if the worker failed or ended
+ * (e.g. killed) before delivering it
+ */
+RunStatistics ReplicationShards::next() {
+    if (delivered >= maximum) {
+        throw runtime_error("No replications left");
+    }
+    int shard = delivered % processes;
+    Channel& channel = shared->channels[shard];
+    long head = channel.head.load(memory_order_relaxed);
+    string ended = "ended earlier";
+    while (channel.tail.load(memory_order_acquire) == head) {
+        if (channel.failed.load(memory_order_acquire)) {
+            throw runtime_error(string("Worker failed: ") + channel.message);
+        }
+        if (workers[shard] < 0) {
+            throw runtime_error("Worker " + to_string(shard) + " " + ended + " before delivering replication " +
+                                to_string(delivered));
+        }
+        int status;
+        if (waitpid(workers[shard], &status, WNOHANG) == workers[shard]) {
+            // look again at what it delivered (or reported) before ending
+            workers[shard] = -1;
+            ended = describeExit(status);
+            continue;
+        }
+        this_thread::sleep_for(chrono::microseconds(100));
+    }
+    RunStatistics statistics = channel.slots[head % CHANNEL_SLOTS];
+    channel.head.store(head + 1, memory_order_release);
+    delivered++;
+    return statistics;
+}
+
+/*
+ * Tells the workers to finish the run they are in and waits for them
+ */
+void ReplicationShards::stop() {
+    if (workers.empty()) {
+        return;
+    }
+    shared->stopping = 1;
+    for (pid_t pid : workers) {
+        // workers that ended were already waited for by next()
+        if (pid > 0) {
+            waitpid(pid, nullptr, 0);
+        }
+    }
+    workers.clear();
+}
+
+#endif
@@ -0,0 +1,65 @@
+#ifndef __REPLICATION_SHARDS_H__
+#define __REPLICATION_SHARDS_H__
+
+#include <atomic>
+#include <vector>
+#include <sys/types.h>
+#include "SimConfig.h"
+#include "RunStatistics.h"
+#include "ResultCache.h"
+
+using namespace std;
+
+/*
+ * Runs the replications of a configuration in several worker processes on
+ * the same machine. Worker k owns the replications k, k + processes, ...
+ * (seed firstSeed + replication) and passes the statistics of each run back
+ * through its own single-producer single-consumer ring in shared memory; no
+ * network or files are involved. next() returns the results in replication
+ * order, so a caller sees exactly the sequence a single process would produce
+ * and stops at the same point. Each process builds its own Simulator, so
+ * memory and CPU scale with the number of processes.
+ */
+class ReplicationShards {
+    private:
+        static const int CHANNEL_SLOTS = 64;
+        static const int MESSAGE_BYTES = 256;
+
+        // Ring of one worker, placed in memory shared by all the processes
+        struct Channel {
+            alignas(64) atomic<long> head;  // next slot to read (parent)
+            alignas(64) atomic<long> tail;  // next slot to write (worker)
+            atomic<int> failed;
+            char message[MESSAGE_BYTES];    // what went wrong in the worker
+            RunStatistics slots[CHANNEL_SLOTS];
+        };
+
+        struct Shared {
+            alignas(64) atomic<int> stopping;
+            Channel channels[1];            // one per process (more follow)
+        };
+
+        Shared* shared;
+        size_t sharedBytes;
+        vector<pid_t> workers;
+        int processes;
+        int maximum;
+        int delivered;
+
+        static size_t bytesFor(int processes);
+        void work(int shard, const SimConfig& config, int firstSeed, const ResultCache* cache);
+
+    public:
+        ReplicationShards(const SimConfig& config, int firstSeed, int processes, int maximum,
+                          const ResultCache* cache = nullptr);
+        ~ReplicationShards();
+        ReplicationShards(const ReplicationShards&) = delete;
+        ReplicationShards& operator=(const ReplicationShards&) = delete;
+
+        RunStatistics next();
+        void stop();
+
+        inline int getProcesses() const { return processes; }
+};
+
+#endif
@@ -0,0 +1,212 @@
+#ifndef __RESULT_CACHE_CPP__
+#define __RESULT_CACHE_CPP__
+
+#include "ResultCache.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utime.h>
+
+using namespace std;
+
+// Extension of the cache files (anything else in the directory is left alone)
+static const string CACHE_EXTENSION = ".run";
+
+/*
+ * @param const string& directory created if missing
+ * @param long maxBytes size above which the least recently used files are removed
+ * @throws runtime_error if the directory can't be created
+ */
+ResultCache::ResultCache(const string& directory, long maxBytes)
+        : directory(directory), maxBytes(maxBytes), unchecked(maxBytes) {
+    if (mkdir(directory.c_str(), 0777) != 0 && errno != EEXIST) {
+        throw runtime_error("Unable to create cache directory: " + directory);
+    }
+}
+
+/*
+ * @param const SimConfig& config
+ * @param int seed
+ * @return string everything that determines the results of a run, one item per line
+ */
+string ResultCache::keyFor(const SimConfig& config, int seed) {
+    ostringstream key;
+    key.precision(17);
+    key << "engine " << ENGINE_VERSION << "\n" << "seed " << seed << "\n";
+    // parameters are normalized and sorted by name
+    for (const auto& parameter : config.getParameters()) {
+        key << parameter.first << " " << parameter.second << "\n";
+    }
+    return key.str();
+}
+
+/*
+ * @param const string& key
+ * @return uint64_t FNV-1a hash of the key
+ */
+uint64_t ResultCache::hashOf(const string& key) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (unsigned char c : key) {
+        hash ^= c;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+/*
+ * @param const string& key
+ * @return string path of the file holding the results of the key
+ */
+string ResultCache::pathFor(const string& key) const {
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx", static_cast<unsigned long long>(hashOf(key)));
+    return directory + "/" + name + CACHE_EXTENSION;
+}
+
+/*
+ * @param const SimConfig& config
+ * @param int seed
+ * @param RunStatistics& statistics receives the stored totals
+ * @return bool true if the run was found
+ */
+bool ResultCache::lookup(const SimConfig& config, int seed, RunStatistics& statistics) const {
+    string key = keyFor(config, seed);
+    string path = pathFor(key);
+    ifstream file(path);
+    if (!file) {
+        return false;
+    }
+
+    stringstream contents;
+    contents << file.rdbuf();
+    string text = contents.str();
+    if (text.compare(0, key.size(), key) != 0) {
+        // another run with the same hash
+        return false;
+    }
+
+    istringstream values(text.substr(key.size()));
+    string separator;
+    RunStatistics stored;
+    if (!(values >> separator >> stored.arrivals >> stored.exited >> stored.totalTravelTime
+                 >> stored.totalDelay >> stored.queueLengthSum >> stored.ticks >> stored.stalled) || separator != "---") {
+        return false;
+    }
+    statistics = stored;
+
+    // most recently used: kept longest when trimming
+    utime(path.c_str(), nullptr);
+    return true;
+}
+
+/*
+ * Writes the totals of a run (under a temporary name, then renamed)
+ * @param const SimConfig& config
+ * @param int seed
+ * @param const RunStatistics& statistics
+ * @throws runtime_error if the file can't be written
+ */
+void ResultCache::store(const SimConfig& config, int seed, const RunStatistics& statistics) const {
+    string key = keyFor(config, seed);
+    string path = pathFor(key);
+    // unique among the processes and threads sharing the directory
+    static atomic<long> written(0);
+    string temporary = path + ".tmp" + to_string(getpid()) + "." + to_string(written++);
+    long bytes;
+    {
+        ofstream file(temporary);
+        file << key << "---\n" << statistics.arrivals << " " << statistics.exited << " "
+             << statistics.totalTravelTime << " " << statistics.totalDelay << " " << statistics.queueLengthSum << " " << statistics.ticks << " "
+             << statistics.stalled << "\n";
+        bytes = file.tellp();
+        if (!file) {
+            unlink(temporary.c_str());
+            throw runtime_error("Unable to write cache file: " + temporary);
+        }
+    }
+    if (rename(temporary.c_str(), path.c_str()) != 0) {
+        unlink(temporary.c_str());
+        throw runtime_error("Unable to write cache file: " + path);
+    }
+
+    // listing the directory costs more than a run for large stores: only
+    // do it once a sixteenth of the limit has been written since the last time
+    if ((unchecked += bytes) >= maxBytes / 16) {
+        unchecked = 0;
+        trim();
+    }
+}
+
+/*
+ * Removes the least recently used files until the store fits its size limit
+ */
+void ResultCache::trim() const {
+    DIR* listing = opendir(directory.c_str());
+    if (listing == nullptr) {
+        return;
+    }
+
+    vector<pair<pair<time_t, long>, string>> files;   // last use (seconds, nanoseconds), path
+    long total = 0;
+    for (dirent* entry = readdir(listing); entry != nullptr; entry = readdir(listing)) {
+        string name = entry->d_name;
+        if (name.size() <= CACHE_EXTENSION.size() ||
+                name.compare(name.size() - CACHE_EXTENSION.size(), CACHE_EXTENSION.size(), CACHE_EXTENSION) != 0) {
+            continue;
+        }
+        string path = directory + "/" + name;
+        struct stat status;
+        if (stat(path.c_str(), &status) == 0) {
+            total += status.st_size;
+            // to the nanosecond: runs used within the same second keep their order
+            files.push_back(make_pair(make_pair(status.st_mtim.tv_sec, status.st_mtim.tv_nsec), path));
+        }
+    }
+    closedir(listing);
+
+    if (total <= maxBytes) {
+        return;
+    }
+    sort(files.begin(), files.end());
+    for (const auto& file : files) {
+        struct stat status;
+        if (total <= maxBytes) {
+            break;
+        }
+        if (stat(file.second.c_str(), &status) == 0 && unlink(file.second.c_str()) == 0) {
+            total -= status.st_size;
+        }
+    }
+}
+
+/*
+ * Runs a whole simulation from time 0, or returns its stored totals
+ * @param Simulator& sim simulator to run on a miss (reset with the seed)
+ * @param int seed
+ * @return RunStatistics totals of the run
+ */
+RunStatistics ResultCache::run(Simulator& sim, int seed) const {
+    RunStatistics statistics;
+    // demand profiles and arrival logs are not part of the configuration
+    bool cacheable = !sim.hasExternalDemand();
+    if (cacheable && lookup(sim.getConfig(), seed, statistics)) {
+        return statistics;
+    }
+    sim.reset(seed);
+    sim.step(sim.getConfig().simTime);
+    if (cacheable) {
+        store(sim.getConfig(), seed, sim.getStatistics());
+    }
+    return sim.getStatistics();
+}
+
+#endif
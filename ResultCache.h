@@ -0,0 +1,45 @@
+#ifndef __RESULT_CACHE_H__
+#define __RESULT_CACHE_H__
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include "Simulator.h"
+#include "RunStatistics.h"
+
+using namespace std;
+
+/*
+ * Totals of finished runs stored on disk, so that a sweep point already run
+ * (by this job or an earlier one) costs a file lookup instead of a full run.
+ * A run is identified by the normalized parameters of its configuration, the
+ * seed and ENGINE_VERSION; the file is named after a hash of the three and
+ * holds them in full, so a hash collision is detected rather than returned.
+ * Files are written under a temporary name and renamed, so concurrent
+ * processes never read half a file. When the store outgrows its size limit
+ * the least recently used files are removed (checked after every sixteenth
+ * of the limit written, so the store may briefly exceed it by that much).
+ */
+class ResultCache {
+    private:
+        string directory;
+        long maxBytes;
+        mutable atomic<long> unchecked;    // bytes stored since the size was last checked
+
+        static string keyFor(const SimConfig& config, int seed);
+        static uint64_t hashOf(const string& key);
+        string pathFor(const string& key) const;
+        void trim() const;
+
+    public:
+        ResultCache(const string& directory, long maxBytes = 256L << 20);
+
+        bool lookup(const SimConfig& config, int seed, RunStatistics& statistics) const;
+        void store(const SimConfig& config, int seed, const RunStatistics& statistics) const;
+
+        RunStatistics run(Simulator& sim, int seed) const;
+
+        inline const string& getDirectory() const { return directory; }
+};
+
+#endif
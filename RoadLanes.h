@@ -0,0 +1,375 @@
+#ifndef __ROAD_LANES_H__
+#define __ROAD_LANES_H__
+
+#include <algorithm>
+#include <array>
+#include <vector>
+#include <string>
+#include "VehicleBase.h"
+
+using namespace std;
+
+// Which lane storage the Simulator uses
+enum class LaneEngine {automatic, dynamic, queue};
+
+// Roads at least this long use QueueLanes when the engine is automatic
+const int QUEUE_LANES_MIN_ROAD_LENGTH = 10000;
+
+/*
+ * One bound stored as a plain array of sections (std::array or vector)
+ */
+template <class Storage>
+class CellLane {
+    private:
+        Storage cells;
+
+    public:
+        CellLane() {}
+        CellLane(int size) : cells(size, nullptr) {}
+
+        // Marks sections first ... last (inclusive, none if first > last) as held by vehicle
+        inline void paint(int first, int last, VehicleBase* vehicle) {
+            for (int i = last; i >= first; i--) {
+                cells[i] = vehicle;
+            }
+        }
+        inline void set(int section, VehicleBase* vehicle) { cells[section] = vehicle; }
+        inline VehicleBase* at(int section) const { return cells[section]; }
+        inline VehicleBase* const* data() const { return cells.data(); }
+        inline int size() const { return cells.size(); }
+        inline void clear() { fill(cells.begin(), cells.end(), nullptr); }
+};
+
+// Sections first ... last of a QueueLane held by one vehicle
+struct LaneSpan {
+    int first;
+    int last;
+    VehicleBase* vehicle;
+};
+
+/*
+ * One bound of a long road stored by vehicle instead of by section. Only the
+ * sections around the intersection (where vehicles turn in and out and the
+ * reservations are made) are kept as an array; before it, the vehicles of the
+ * bound form a FIFO, so their spans are kept in order from the intersection
+ * back and "is this section free" is a binary search. Beyond it vehicles move
+ * without checks and their spans are only kept for drawing. Memory and work
+ * per tick depend on the number of vehicles, not on the road length.
+ */
+class QueueLane {
+    public:
+        static const int WINDOW = 8;    // sections kept as an array on each side of roadLen
+
+    private:
+        int sections;
+        int windowFirst;
+        vector<VehicleBase*> window;
+        vector<LaneSpan> approach;      // below the window, by decreasing position
+        vector<LaneSpan> departure;     // above the window, in painting order
+
+    public:
+        QueueLane(int roadLen = 0)
+            : sections(roadLen * 2 + 2), windowFirst(max(0, roadLen - WINDOW)),
+              window(min(sections - 1, roadLen + WINDOW) - windowFirst + 1, nullptr) {}
+
+        void paint(int first, int last, VehicleBase* vehicle);
+        void set(int section, VehicleBase* vehicle);
+        VehicleBase* at(int section) const;
+        void copyTo(vector<VehicleBase*>& cells) const;
+        void copyRange(int first, int last, VehicleBase** out) const;
+        void countOccupied(int first, int last, int blockSize, int* counts) const;
+        void clear();
+
+        inline int size() const { return sections; }
+};
+
+/*
+ * Marks sections first ... last (inclusive, none if first > last) as held by vehicle
+ */
+inline void QueueLane::paint(int first, int last, VehicleBase* vehicle) {
+    if (first > last) {
+        return;
+    }
+    int windowLast = windowFirst + window.size() - 1;
+
+    for (int i = max(first, windowFirst); i <= min(last, windowLast); i++) {
+        window[i - windowFirst] = vehicle;
+    }
+    if (last > windowLast) {
+        departure.push_back(LaneSpan{max(first, windowLast + 1), last, vehicle});
+    }
+    if (first < windowFirst) {
+        LaneSpan span {first, min(last, windowFirst - 1), vehicle};
+        // followers are painted after their leader, so this is normally an append
+        if (approach.empty() || approach.back().first > span.last) {
+            approach.push_back(span);
+        } else {
+            auto position = upper_bound(approach.begin(), approach.end(), span.last,
+                [](int section, const LaneSpan& other) { return section > other.last; });
+            approach.insert(position, span);
+        }
+    }
+}
+
+inline void QueueLane::set(int section, VehicleBase* vehicle) {
+    paint(section, section, vehicle);
+}
+
+/*
+ * @param int section
+ * @return VehicleBase* vehicle that painted the section this tick (the last one
+ * if several did), nullptr if it's free
+ */
+inline VehicleBase* QueueLane::at(int section) const {
+    if (section >= windowFirst && section < windowFirst + static_cast<int>(window.size())) {
+        return window[section - windowFirst];
+    }
+    if (section < windowFirst) {
+        // first span (in decreasing order) that doesn't end above the section
+        auto span = lower_bound(approach.begin(), approach.end(), section,
+            [](const LaneSpan& other, int section) { return other.first > section; });
+        if (span != approach.end() && span->last >= section) {
+            return span->vehicle;
+        }
+        return nullptr;
+    }
+    for (auto span = departure.rbegin(); span != departure.rend(); span++) {
+        if (span->first <= section && section <= span->last) {
+            return span->vehicle;
+        }
+    }
+    return nullptr;
+}
+
+/*
+ * Writes every section into a dense vector (used for drawing)
+ * @param vector<VehicleBase*>& cells resized to the number of sections
+ */
+inline void QueueLane::copyTo(vector<VehicleBase*>& cells) const {
+    cells.assign(sections, nullptr);
+    for (const LaneSpan& span : approach) {
+        fill(cells.begin() + span.first, cells.begin() + span.last + 1, span.vehicle);
+    }
+    copy(window.begin(), window.end(), cells.begin() + windowFirst);
+    for (const LaneSpan& span : departure) {
+        fill(cells.begin() + span.first, cells.begin() + span.last + 1, span.vehicle);
+    }
+}
+
+/*
+ * Writes sections first ... last into out without building the whole lane
+ * @param int first
+ * @param int last
+ * @param VehicleBase** out receives last - first + 1 entries
+ */
+inline void QueueLane::copyRange(int first, int last, VehicleBase** out) const {
+    fill(out, out + (last - first + 1), nullptr);
+    auto paintSpan = [&](const LaneSpan& span) {
+        for (int i = max(first, span.first); i <= min(last, span.last); i++) {
+            out[i - first] = span.vehicle;
+        }
+    };
+    // approach spans are in decreasing order: skip the ones above the range
+    auto span = lower_bound(approach.begin(), approach.end(), last,
+        [](const LaneSpan& other, int section) { return other.first > section; });
+    for (; span != approach.end() && span->last >= first; span++) {
+        paintSpan(*span);
+    }
+    for (int i = max(first, windowFirst); i <= min(last, windowFirst + static_cast<int>(window.size()) - 1); i++) {
+        out[i - first] = window[i - windowFirst];
+    }
+    for (const LaneSpan& departing : departure) {
+        paintSpan(departing);
+    }
+}
+
+/*
+ * Counts the occupied sections of first ... last by blocks of blockSize
+ * sections, in one pass over the spans
+ * @param int first
+ * @param int last
+ * @param int blockSize
+ * @param int* counts receives one count per block (the last block may be shorter)
+ */
+inline void QueueLane::countOccupied(int first, int last, int blockSize, int* counts) const {
+    int blocks = (last - first) / blockSize + 1;
+    fill(counts, counts + blocks, 0);
+    auto countSpan = [&](int spanFirst, int spanLast) {
+        spanFirst = max(first, spanFirst);
+        spanLast = min(last, spanLast);
+        while (spanFirst <= spanLast) {
+            int block = (spanFirst - first) / blockSize;
+            int blockLast = min(spanLast, first + (block + 1) * blockSize - 1);
+            counts[block] += blockLast - spanFirst + 1;
+            spanFirst = blockLast + 1;
+        }
+    };
+    auto span = lower_bound(approach.begin(), approach.end(), last,
+        [](const LaneSpan& other, int section) { return other.first > section; });
+    for (; span != approach.end() && span->last >= first; span++) {
+        countSpan(span->first, span->last);
+    }
+    for (int i = max(first, windowFirst); i <= min(last, windowFirst + static_cast<int>(window.size()) - 1); i++) {
+        if (window[i - windowFirst] != nullptr) {
+            countSpan(i, i);
+        }
+    }
+    for (const LaneSpan& departing : departure) {
+        countSpan(departing.first, departing.last);
+    }
+    // spans painted over each other are counted twice
+    for (int block = 0; block < blocks; block++) {
+        counts[block] = min(counts[block], min(blockSize, last - first + 1 - block * blockSize));
+    }
+}
+
+inline void QueueLane::clear() {
+    fill(window.begin(), window.end(), nullptr);
+    approach.clear();
+    departure.clear();
+}
+
+// Read-only view of the sections of one bound (whatever the lane storage)
+class LaneView {
+    private:
+        VehicleBase* const* sections;   // array storage, or nullptr
+        const QueueLane* queue;         // QueueLanes storage, or nullptr
+        int count;
+
+    public:
+        LaneView(VehicleBase* const* sections, int count) : sections(sections), queue(nullptr), count(count) {}
+        LaneView(const QueueLane* queue) : sections(nullptr), queue(queue), count(queue->size()) {}
+
+        inline VehicleBase* operator[](int i) const { return sections ? sections[i] : queue->at(i); }
+        inline int size() const { return count; }
+        inline vector<VehicleBase*> toVector() const {
+            vector<VehicleBase*> cells;
+            if (sections) {
+                cells.assign(sections, sections + count);
+            } else {
+                queue->copyTo(cells);
+            }
+            return cells;
+        }
+
+        // Writes sections first ... last into out
+        inline void copyRange(int first, int last, VehicleBase** out) const {
+            if (sections) {
+                copy(sections + first, sections + last + 1, out);
+            } else {
+                queue->copyRange(first, last, out);
+            }
+        }
+
+        // Number of occupied sections in each block of blockSize sections of first ... last
+        inline void countOccupied(int first, int last, int blockSize, int* counts) const {
+            if (!sections) {
+                queue->countOccupied(first, last, blockSize, counts);
+                return;
+            }
+            fill(counts, counts + (last - first) / blockSize + 1, 0);
+            for (int i = first; i <= last; i++) {
+                counts[(i - first) / blockSize] += sections[i] != nullptr;
+            }
+        }
+};
+
+/*
+ * Lanes of a road with RoadLen sections before the intersection, stored inline
+ * in fixed-size arrays. The road length and the intersection offsets
+ * (RoadLen+1 ... RoadLen+4) are compile-time constants, so the simulation
+ * kernels instantiated on this type index the lanes with constant offsets.
+ */
+template <int RoadLen>
+class FixedLanes {
+    public:
+        static constexpr int SECTIONS = RoadLen * 2 + 2;
+        typedef CellLane<array<VehicleBase*, SECTIONS>> Lane;
+
+    private:
+        Lane bounds[4];     // indexed by Direction
+
+    public:
+        FixedLanes() { clear(); }
+
+        static constexpr int getRoadLen() { return RoadLen; }
+        static string getName() { return "fixed<" + to_string(RoadLen) + ">"; }
+
+        inline Lane& lane(Direction direction) { return bounds[static_cast<int>(direction)]; }
+        inline LaneView view(Direction direction) const {
+            return LaneView(bounds[static_cast<int>(direction)].data(), SECTIONS);
+        }
+        inline void clear() {
+            for (Lane& lane : bounds) {
+                lane.clear();
+            }
+        }
+};
+
+/*
+ * Lanes of a road of any length, stored in vectors (fallback for the road
+ * lengths without a FixedLanes instantiation)
+ */
+class DynamicLanes {
+    public:
+        typedef CellLane<vector<VehicleBase*>> Lane;
+
+    private:
+        int roadLen;
+        Lane bounds[4];     // indexed by Direction
+
+    public:
+        DynamicLanes(int roadLen = 0) : roadLen(roadLen) {
+            for (Lane& lane : bounds) {
+                lane = Lane(roadLen * 2 + 2);
+            }
+        }
+
+        inline int getRoadLen() const { return roadLen; }
+        static string getName() { return "dynamic"; }
+
+        inline Lane& lane(Direction direction) { return bounds[static_cast<int>(direction)]; }
+        inline LaneView view(Direction direction) const {
+            const Lane& lane = bounds[static_cast<int>(direction)];
+            return LaneView(lane.data(), lane.size());
+        }
+        inline void clear() {
+            for (Lane& lane : bounds) {
+                lane.clear();
+            }
+        }
+};
+
+/*
+ * Lanes of a very long road, stored by vehicle (see QueueLane)
+ */
+class QueueLanes {
+    public:
+        typedef QueueLane Lane;
+
+    private:
+        int roadLen;
+        Lane bounds[4];     // indexed by Direction
+
+    public:
+        QueueLanes(int roadLen = 0) : roadLen(roadLen) {
+            for (Lane& lane : bounds) {
+                lane = Lane(roadLen);
+            }
+        }
+
+        inline int getRoadLen() const { return roadLen; }
+        static string getName() { return "queue"; }
+
+        inline Lane& lane(Direction direction) { return bounds[static_cast<int>(direction)]; }
+        inline LaneView view(Direction direction) const {
+            return LaneView(&bounds[static_cast<int>(direction)]);
+        }
+        inline void clear() {
+            for (Lane& lane : bounds) {
+                lane.clear();
+            }
+        }
+};
+
+#endif
@@ -0,0 +1,248 @@
+#include "Simulator.h"
+#include "SampleStatistics.h"
+#include "ReplicationShards.h"
+
+#include <cmath>
+#include <cstdio>
+#include <stdexcept>
+
+using namespace std;
+
+static void printUsage() {
+    cerr << "Usage: ./RunReplications [config_file] [first_seed] [options]" << endl;
+    cerr << "Runs replications until the confidence interval of every measure is narrow enough" << endl;
+    cerr << "  --kpi NAME          measure to estimate: delay, travel_time, throughput or queue (repeatable," << endl;
+    cerr << "                      default delay and throughput)" << endl;
+    cerr << "  --precision R       stop when every half-width is below R times the mean (default 0.05)" << endl;
+    cerr << "  --halfwidth H       stop when every half-width is below H instead" << endl;
+    cerr << "  --confidence C      confidence level of the intervals (default 0.95)" << endl;
+    cerr << "  --min N             replications (or batches) before the first check (default 5)" << endl;
+    cerr << "  --max N             budget of replications (or batches) (default 100)" << endl;
+    cerr << "  --processes P       run the replications in P worker processes (same results)" << endl;
+    cerr << "  --cache DIR         reuse the results of runs stored in DIR (and store new ones)" << endl;
+    cerr << "  --batch-means T     one long run cut into batches of T ticks instead of replications" << endl;
+    cerr << "  --warmup W          ticks discarded before the first batch (default 0)" << endl;
+}
+
+// Stopping rule shared by both modes
+struct StoppingRule {
+    vector<Kpi> kpis;
+    double precision;       // relative target, used when halfWidth is 0
+    double halfWidth;       // absolute target
+    double confidence;
+    int minimum;
+    int maximum;
+};
+
+/*
+ * @param const StoppingRule& rule
+ * @param const vector<SampleStatistics>& samples one per measure of the rule
+ * @return bool true if every interval meets its target
+ */
+static bool targetMet(const StoppingRule& rule, const vector<SampleStatistics>& samples) {
+    if (samples[0].getCount() < rule.minimum) {
+        return false;
+    }
+    for (const SampleStatistics& sample : samples) {
+        double target = rule.halfWidth > 0 ? rule.halfWidth : rule.precision * fabs(sample.getMean());
+        if (!(sample.getHalfWidth(rule.confidence) <= target)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*
+ * Prints one line per measure: mean, half-width and relative half-width
+ * @param const StoppingRule& rule
+ * @param const vector<SampleStatistics>& samples
+ */
+static void printIntervals(const StoppingRule& rule, const vector<SampleStatistics>& samples) {
+    for (size_t k = 0; k < rule.kpis.size(); k++) {
+        const SampleStatistics& sample = samples[k];
+        double halfWidth = sample.getHalfWidth(rule.confidence);
+        double relative = sample.getMean() != 0 ? halfWidth / fabs(sample.getMean()) : 0;
+        printf("  %-22s %12.4f +- %10.4f (%5.1f%%)\n", RunStatistics::kpiLabel(rule.kpis[k]).c_str(),
+               sample.getMean(), halfWidth, 100 * relative);
+    }
+}
+
+/*
+ * Independent replications: one simulator reset with consecutive seeds, or
+ * worker processes each running a share of the seeds (results are taken in
+ * seed order, so the stopping point is the same)
+ * @param int processes 1 to run in this process
+ * @param const ResultCache* cache stored runs to reuse (none if nullptr)
+ * @return bool true if the target was met within the budget
+ */
+static bool runReplications(const SimConfig& config, int firstSeed, const StoppingRule& rule, int processes,
+                            const ResultCache* cache) {
+    unique_ptr<Simulator> sim;
+    unique_ptr<ReplicationShards> shards;
+    if (processes > 1) {
+        shards.reset(new ReplicationShards(config, firstSeed, processes, rule.maximum, cache));
+    } else {
+        sim.reset(new Simulator(config, firstSeed));
+    }
+    vector<SampleStatistics> samples(rule.kpis.size());
+    int stalled = 0;
+
+    while (samples[0].getCount() < rule.maximum && !targetMet(rule, samples)) {
+        RunStatistics statistics;
+        if (shards) {
+            statistics = shards->next();
+        } else if (cache != nullptr) {
+            statistics = cache->run(*sim, firstSeed + samples[0].getCount());
+        } else {
+            sim->reset(firstSeed + samples[0].getCount());
+            sim->step(config.simTime);
+            statistics = sim->getStatistics();
+        }
+        stalled += statistics.stalled;
+        for (size_t k = 0; k < rule.kpis.size(); k++) {
+            samples[k].add(statistics.getKpi(rule.kpis[k]));
+        }
+    }
+    if (shards) {
+        shards->stop();
+    }
+
+    bool met = targetMet(rule, samples);
+    cout << samples[0].getCount() << " replications of " << config.simTime << " ticks";
+    if (shards) {
+        cout << " in " << processes << " processes";
+    }
+    cout << ", " << 100 * rule.confidence << "% confidence intervals" << endl;
+    printIntervals(rule, samples);
+    if (stalled > 0) {
+        cout << "  " << stalled << " replications stalled and were aborted (stall_ticks)" << endl;
+    }
+    return met;
+}
+
+/*
+ * Batch means: one long run after a warm-up, each batch of batchSize ticks
+ * giving one observation. The lag-1 autocorrelation of the batch means tells
+ * whether the batches are long enough to be treated as independent.
+ * @return bool true if the target was met within the budget
+ */
+static bool runBatchMeans(const SimConfig& config, int seed, const StoppingRule& rule, int batchSize, int warmup) {
+    // the run only has to last as long as the largest budget
+    map<string, double> parameters = config.getParameters();
+    parameters["maximum_simulated_time"] = warmup + static_cast<double>(rule.maximum) * batchSize;
+    Simulator sim(SimConfig::fromParameters(parameters), seed);
+    vector<SampleStatistics> samples(rule.kpis.size());
+    vector<double> firstMeans;
+
+    sim.step(warmup);
+    RunStatistics previous = sim.getStatistics();
+    while (samples[0].getCount() < rule.maximum && !targetMet(rule, samples) && !sim.isStalled()) {
+        sim.step(batchSize);
+        RunStatistics current = sim.getStatistics();
+        RunStatistics batch = current.since(previous);
+        previous = current;
+        for (size_t k = 0; k < rule.kpis.size(); k++) {
+            samples[k].add(batch.getKpi(rule.kpis[k]));
+        }
+        firstMeans.push_back(batch.getKpi(rule.kpis[0]));
+    }
+
+    bool met = targetMet(rule, samples);
+    cout << samples[0].getCount() << " batches of " << batchSize << " ticks after " << warmup
+         << " warm-up ticks, " << 100 * rule.confidence << "% confidence intervals" << endl;
+    printIntervals(rule, samples);
+    if (sim.isStalled()) {
+        cout << "  " << sim.describeStall() << endl;
+    }
+
+    double mean = samples[0].getMean();
+    double covariance = 0;
+    double variance = 0;
+    for (size_t b = 0; b < firstMeans.size(); b++) {
+        variance += (firstMeans[b] - mean) * (firstMeans[b] - mean);
+        if (b > 0) {
+            covariance += (firstMeans[b] - mean) * (firstMeans[b - 1] - mean);
+        }
+    }
+    double autocorrelation = variance > 0 ? covariance / variance : 0;
+    printf("  lag-1 autocorrelation of the %s batch means: %.3f%s\n", RunStatistics::kpiName(rule.kpis[0]).c_str(),
+           autocorrelation, fabs(autocorrelation) > 0.2 ? " (batches probably too short)" : "");
+    return met;
+}
+
+int main(int argc, char* argv[]) {
+
+    if (argc < 3) {
+        printUsage();
+        exit(0);
+    }
+
+    try {
+        SimConfig config = SimConfig::fromFile(argv[1]);
+        int firstSeed = stoi(argv[2]);
+        StoppingRule rule{{}, 0.05, 0, 0.95, 5, 100};
+        int batchSize = 0;
+        int warmup = 0;
+        int processes = 1;
+        unique_ptr<ResultCache> cache;
+
+        for (int a = 3; a < argc; a++) {
+            string option = argv[a];
+            if (a + 1 >= argc) {
+                throw runtime_error("Missing value for " + option);
+            }
+            string value = argv[++a];
+            if (option == "--kpi") {
+                rule.kpis.push_back(RunStatistics::kpiFromName(value));
+            } else if (option == "--precision") {
+                rule.precision = stod(value);
+            } else if (option == "--halfwidth") {
+                rule.halfWidth = stod(value);
+            } else if (option == "--confidence") {
+                rule.confidence = stod(value);
+            } else if (option == "--min") {
+                rule.minimum = stoi(value);
+            } else if (option == "--max") {
+                rule.maximum = stoi(value);
+            } else if (option == "--batch-means") {
+                batchSize = stoi(value);
+            } else if (option == "--processes") {
+                processes = stoi(value);
+            } else if (option == "--cache") {
+                cache.reset(new ResultCache(value));
+            } else if (option == "--warmup") {
+                warmup = stoi(value);
+            } else {
+                throw runtime_error("Unknown option: " + option);
+            }
+        }
+        if (rule.kpis.empty()) {
+            rule.kpis = {Kpi::delay, Kpi::throughput};
+        }
+        if (rule.confidence <= 0 || rule.confidence >= 1) {
+            throw runtime_error("--confidence must be between 0 and 1");
+        }
+        rule.minimum = max(rule.minimum, 2);
+        if (rule.maximum < rule.minimum) {
+            throw runtime_error("--max must be at least --min (and at least 2)");
+        }
+        if (processes < 1) {
+            throw runtime_error("--processes must be at least 1");
+        }
+        if (batchSize < 0 || warmup < 0) {
+            throw runtime_error("--batch-means and --warmup must not be negative");
+        }
+        // batch means is one run: nothing to share out or look up
+        if (batchSize > 0 && (processes > 1 || cache)) {
+            throw runtime_error("--processes and --cache don't apply to --batch-means");
+        }
+
+        bool met = batchSize > 0 ? runBatchMeans(config, firstSeed, rule, batchSize, warmup)
+                                 : runReplications(config, firstSeed, rule, processes, cache.get());
+        cout << (met ? "target met" : "budget exhausted before the target was met") << endl;
+        return met ? 0 : 1;
+    } catch (const exception& e) {
+        cerr << e.what() << endl;
+        return 2;
+    }
+}
@@ -1,17 +1,259 @@
 #include "Simulator.h"
+#include "FrameExporter.h"
+#include "ReplayFile.h"
+#include "ControlChannel.h"
+#include "TickPacer.h"
+
+#include <cmath>
+#include <memory>
+#include <stdexcept>
 
 using namespace std;
 
+static void printUsage() {
+    cerr << "Usage: ./RunSimulation [file_name] [seed] [options]" << endl;
+    cerr << "Options:" << endl;
+    cerr << "  --export FILE        record the animation (.cast: asciicast, else raw ANSI)" << endl;
+    cerr << "  --export-every N     record one frame out of every N ticks" << endl;
+    cerr << "  --no-wait            don't wait for a key press between ticks" << endl;
+    cerr << "  --no-display         don't draw the animation in the terminal" << endl;
+    cerr << "  --viewport N         draw only N sections on each side of the intersection" << endl;
+    cerr << "  --density-blocks M   draw the rest of each half lane as M occupancy blocks (default 8)" << endl;
+    cerr << "  --id-digits D        draw sections D characters wide (default 4; larger IDs are drawn as '*'" << endl;
+    cerr << "                       and their last D-1 digits)" << endl;
+    cerr << "  --demand FILE        arrival rates and proportions over time (see demand_profile_format.txt)" << endl;
+    cerr << "  --arrivals FILE      replay recorded arrivals (binary or CSV log) instead of random ones" << endl;
+    cerr << "  --lifetimes FILE     record every vehicle leaving the map (columnar binary file)" << endl;
+    cerr << "  --lifetimes-csv FILE also record them as CSV (needs --lifetimes)" << endl;
+    cerr << "  --occupancy FILE     write the ticks every section was held (and held stopped) as CSV" << endl;
+    cerr << "  --record FILE        record the run for ReplayRun (seekable to any tick)" << endl;
+    cerr << "  --keyframe-every K   store one full frame every K ticks in the recording (default 1000)" << endl;
+    cerr << "  --control SOCKET     accept pause, step, stats, set and stop commands on a Unix socket" << endl;
+    cerr << "  --realtime MS        run one tick every MS milliseconds of wall-clock time (implies --no-wait)" << endl;
+}
+
 int main(int argc, char* argv[]) {
 
     // Checking for appropriate inputs
-    if (3 != argc) {
+    if (argc < 3) {
         cerr << "Invalid number of arguments. Required: 3" << endl;
-        cerr << "Usage: ./RunSimulation [file_name] [seed]" << endl;
+        printUsage();
         exit(0);
     }
 
-    // Running the simulation class
-    Simulator sim = Simulator(argv[1], stoi(argv[2]));
-    sim.runSimulation();
-}
\ No newline at end of file
+    string exportFile;
+    int exportEvery = 1;
+    bool wait = true;
+    bool display = true;
+    int viewport = 0;
+    int densityBlocks = 8;
+    int idDigits = 0;
+    string demandFile;
+    string arrivalsFile;
+    string lifetimesFile;
+    string lifetimesCsvFile;
+    string occupancyFile;
+    string recordFile;
+    int keyframeEvery = 1000;
+    string controlPath;
+    double tickPeriod = 0;
+
+    // a value that isn't a number ends the run like any other error
+    try {
+        for (int a = 3; a < argc; a++) {
+            string option = argv[a];
+            if (option == "--export" && a + 1 < argc) {
+                exportFile = argv[++a];
+            } else if (option == "--export-every" && a + 1 < argc) {
+                exportEvery = stoi(argv[++a]);
+            } else if (option == "--viewport" && a + 1 < argc) {
+                viewport = stoi(argv[++a]);
+            } else if (option == "--density-blocks" && a + 1 < argc) {
+                densityBlocks = stoi(argv[++a]);
+            } else if (option == "--id-digits" && a + 1 < argc) {
+                idDigits = stoi(argv[++a]);
+            } else if (option == "--demand" && a + 1 < argc) {
+                demandFile = argv[++a];
+            } else if (option == "--arrivals" && a + 1 < argc) {
+                arrivalsFile = argv[++a];
+            } else if (option == "--lifetimes" && a + 1 < argc) {
+                lifetimesFile = argv[++a];
+            } else if (option == "--lifetimes-csv" && a + 1 < argc) {
+                lifetimesCsvFile = argv[++a];
+            } else if (option == "--occupancy" && a + 1 < argc) {
+                occupancyFile = argv[++a];
+            } else if (option == "--record" && a + 1 < argc) {
+                recordFile = argv[++a];
+            } else if (option == "--keyframe-every" && a + 1 < argc) {
+                keyframeEvery = stoi(argv[++a]);
+            } else if (option == "--control" && a + 1 < argc) {
+                controlPath = argv[++a];
+            } else if (option == "--realtime" && a + 1 < argc) {
+                tickPeriod = stod(argv[++a]);
+                wait = false;
+            } else if (option == "--no-wait") {
+                wait = false;
+            } else if (option == "--no-display") {
+                display = false;
+                wait = false;
+            } else {
+                cerr << "Unknown option: " << option << endl;
+                printUsage();
+                exit(0);
+            }
+        }
+
+        if (!lifetimesCsvFile.empty() && lifetimesFile.empty()) {
+            throw runtime_error("--lifetimes-csv needs --lifetimes");
+        }
+        // before any Animator is made, including the one runSimulation() draws with
+        if (idDigits != 0) {
+            if (idDigits < 2 || idDigits > 9) {
+                throw runtime_error("--id-digits must be between 2 and 9");
+            }
+            Animator::MAX_VEHICLE_COUNT = static_cast<int>(pow(10, idDigits)) - 1;
+        }
+
+        // Running the simulation class
+        Simulator sim = Simulator(argv[1], stoi(argv[2]));
+        if (!demandFile.empty()) {
+            sim.setDemandProfile(make_shared<const DemandProfile>(DemandProfile::fromFile(demandFile)));
+        }
+        if (!arrivalsFile.empty()) {
+            sim.setArrivalLog(ArrivalLog::open(arrivalsFile));
+        }
+        shared_ptr<LifetimeWriter> lifetimes;
+        if (!lifetimesFile.empty()) {
+            lifetimes = make_shared<LifetimeWriter>(lifetimesFile, lifetimesCsvFile);
+            // classes of the input file are named as in their vehicle_class_ parameter
+            vector<string> typeNames = {"car", "suv", "truck"};
+            for (size_t k = typeNames.size(); k < sim.getConfig().vehicleClasses.size(); k++) {
+                typeNames.push_back(sim.getConfig().vehicleClasses[k].name);
+            }
+            lifetimes->setTypeNames(typeNames);
+            sim.setLifetimeWriter(lifetimes);
+        }
+        shared_ptr<OccupancyMap> occupancy;
+        if (!occupancyFile.empty()) {
+            occupancy = make_shared<OccupancyMap>(sim.getConfig().roadLen);
+            sim.setOccupancyMap(occupancy);
+        }
+
+        if (exportFile.empty() && recordFile.empty() && controlPath.empty() && tickPeriod == 0 && wait && display &&
+                viewport == 0) {
+            sim.runSimulation();
+            if (lifetimes) {
+                lifetimes->close();
+            }
+            if (occupancy) {
+                occupancy->writeCsv(occupancyFile);
+            }
+            if (sim.isStalled()) {
+                cerr << sim.describeStall() << endl;
+                return 3;
+            }
+            return 0;
+        }
+
+        unique_ptr<FrameExporter> exporter;
+        if (!exportFile.empty()) {
+            exporter.reset(new FrameExporter(exportFile, FrameExporter::formatFor(exportFile), exportEvery));
+        }
+
+        unique_ptr<ReplayRecorder> recorder;
+        if (!recordFile.empty()) {
+            recorder.reset(new ReplayRecorder(recordFile, sim.getConfig().roadLen, keyframeEvery));
+        }
+
+        unique_ptr<ControlChannel> control;
+        if (!controlPath.empty()) {
+            control.reset(new ControlChannel(controlPath));
+        }
+
+        unique_ptr<TickPacer> pacer;
+        if (tickPeriod != 0) {
+            pacer.reset(new TickPacer(tickPeriod));
+        }
+
+        Animator anim(sim.getConfig().roadLen, viewport, densityBlocks);
+        char dummy;
+
+        while (!sim.isFinished()) {
+            if (control) {
+                long holds = control->getHolds();
+                if (!control->poll(sim)) {
+                    cerr << "Stopped at tick " << sim.getTime() << endl;
+                    break;
+                }
+                // the time the run was paused is not made up for
+                if (pacer && control->getHolds() != holds) {
+                    pacer->restart();
+                }
+            }
+            if (pacer) {
+                pacer->waitNext();
+            }
+            int time = sim.getTime();
+            sim.step();
+            if (recorder) {
+                recorder->record(sim);
+            }
+
+            bool record = exporter && exporter->wants(time);
+            if (display || record) {
+                anim.setLightNorthSouth(sim.getLightNorthSouth());
+                anim.setLightEastWest(sim.getLightEastWest());
+                anim.setVehiclesNorthbound(sim.getLane(Direction::north));
+                anim.setVehiclesWestbound(sim.getLane(Direction::west));
+                anim.setVehiclesSouthbound(sim.getLane(Direction::south));
+                anim.setVehiclesEastbound(sim.getLane(Direction::east));
+
+                string frame = anim.render(time);
+                if (display) {
+                    cout << frame << flush;
+                }
+                if (record) {
+                    exporter->submit(time, frame);
+                }
+            }
+
+            if (pacer) {
+                pacer->tickDone(time);
+            }
+            if (wait) {
+                cin.get(dummy);
+            }
+        }
+
+        if (pacer) {
+            pacer->report(cerr);
+        }
+        if (lifetimes) {
+            lifetimes->close();
+            cerr << "Recorded " << lifetimes->getWritten() << " vehicles to " << lifetimesFile << endl;
+        }
+        if (occupancy) {
+            occupancy->writeCsv(occupancyFile);
+            cerr << "Wrote the occupancy of " << occupancy->getTicks() << " ticks to " << occupancyFile << endl;
+        }
+        if (recorder) {
+            recorder->close();
+            cerr << "Recorded " << recorder->getFrames() << " ticks to " << recordFile << endl;
+        }
+        if (exporter) {
+            exporter->close();
+            cerr << "Recorded " << exporter->getWritten() << " frames to " << exportFile;
+            if (exporter->getDropped() > 0) {
+                cerr << " (" << exporter->getDropped() << " dropped, writer fell behind)";
+            }
+            cerr << endl;
+        }
+        if (sim.isStalled()) {
+            cerr << sim.describeStall() << endl;
+            return 3;
+        }
+    } catch (const exception& e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+}
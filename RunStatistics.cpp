@@ -0,0 +1,69 @@
+#ifndef __RUN_STATISTICS_CPP__
+#define __RUN_STATISTICS_CPP__
+
+#include "RunStatistics.h"
+
+#include <stdexcept>
+
+using namespace std;
+
+/*
+ * @param Kpi kpi
+ * @return double value of the measure over the ticks covered
+ */
+double RunStatistics::getKpi(Kpi kpi) const {
+    if (kpi == Kpi::travelTime) {
+        return averageTravelTime();
+    } else if (kpi == Kpi::throughput) {
+        return throughput();
+    } else if (kpi == Kpi::delay) {
+        return averageDelay();
+    }
+    return averageQueueLength();
+}
+
+/*
+ * @param Kpi kpi
+ * @return string name used on command lines ("travel_time", "throughput", "queue", "delay")
+ */
+string RunStatistics::kpiName(Kpi kpi) {
+    if (kpi == Kpi::travelTime) {
+        return "travel_time";
+    } else if (kpi == Kpi::throughput) {
+        return "throughput";
+    } else if (kpi == Kpi::delay) {
+        return "delay";
+    }
+    return "queue";
+}
+
+/*
+ * @param Kpi kpi
+ * @return string name with its unit, for reports
+ */
+string RunStatistics::kpiLabel(Kpi kpi) {
+    if (kpi == Kpi::travelTime) {
+        return "travel time (ticks)";
+    } else if (kpi == Kpi::throughput) {
+        return "throughput (veh/tick)";
+    } else if (kpi == Kpi::delay) {
+        return "delay (ticks)";
+    }
+    return "entry queue (veh)";
+}
+
+/*
+ * @param const string& name as returned by kpiName
+ * @return Kpi
+ * @throws runtime_error for an unknown name
+ */
+Kpi RunStatistics::kpiFromName(const string& name) {
+    for (int k = 0; k < KPI_COUNT; k++) {
+        if (kpiName(static_cast<Kpi>(k)) == name) {
+            return static_cast<Kpi>(k);
+        }
+    }
+    throw runtime_error("Unknown measure: " + name + " (travel_time, delay, throughput or queue)");
+}
+
+#endif
@@ -0,0 +1,42 @@
+#ifndef __RUN_STATISTICS_H__
+#define __RUN_STATISTICS_H__
+
+#include <string>
+
+using namespace std;
+
+// Output measures (key performance indicators) of a run
+enum class Kpi {travelTime, throughput, queueLength, delay};
+const int KPI_COUNT = 4;
+
+// Totals collected since the last reset
+struct RunStatistics {
+    long arrivals;          // vehicles that joined an entry queue
+    long exited;            // vehicles that left the map
+    long totalTravelTime;   // ticks from arrival to leaving the map, over the exited vehicles
+    long totalDelay;        // the same less each vehicle's free-flow travel time
+    long queueLengthSum;    // vehicles waiting off the map, summed over the ticks
+    int ticks;
+    int stalled;            // runs aborted because no vehicle could cross the intersection (stall_ticks)
+
+    inline double averageTravelTime() const { return exited > 0 ? static_cast<double>(totalTravelTime) / exited : 0; }
+    inline double averageDelay() const { return exited > 0 ? static_cast<double>(totalDelay) / exited : 0; }
+    inline double throughput() const { return ticks > 0 ? static_cast<double>(exited) / ticks : 0; }
+    inline double averageQueueLength() const { return ticks > 0 ? static_cast<double>(queueLengthSum) / ticks : 0; }
+
+    double getKpi(Kpi kpi) const;
+
+    static string kpiName(Kpi kpi);
+    static string kpiLabel(Kpi kpi);
+    static Kpi kpiFromName(const string& name);
+
+    // Totals between an earlier snapshot and this one (e.g. one batch of a long run)
+    inline RunStatistics since(const RunStatistics& earlier) const {
+        return RunStatistics{arrivals - earlier.arrivals, exited - earlier.exited,
+                             totalTravelTime - earlier.totalTravelTime, totalDelay - earlier.totalDelay,
+                             queueLengthSum - earlier.queueLengthSum, ticks - earlier.ticks,
+                             stalled - earlier.stalled};
+    }
+};
+
+#endif
@@ -0,0 +1,135 @@
+#ifndef __SAMPLE_STATISTICS_CPP__
+#define __SAMPLE_STATISTICS_CPP__
+
+#include "SampleStatistics.h"
+
+#include <cmath>
+#include <limits>
+
+using namespace std;
+
+SampleStatistics::SampleStatistics() : count(0), mean(0), squares(0) {}
+
+/*
+ * @param double value next observation
+ */
+void SampleStatistics::add(double value) {
+    count++;
+    double delta = value - mean;
+    mean += delta / count;
+    squares += delta * (value - mean);
+}
+
+void SampleStatistics::clear() {
+    count = 0;
+    mean = 0;
+    squares = 0;
+}
+
+/*
+ * @return double unbiased sample variance (0 with fewer than two observations)
+ */
+double SampleStatistics::getVariance() const {
+    return count > 1 ? squares / (count - 1) : 0;
+}
+
+double SampleStatistics::getStandardDeviation() const {
+    return sqrt(getVariance());
+}
+
+/*
+ * @param double confidence e.g. 0.95
+ * @return double half-width of the confidence interval of the mean (infinite
+ * with fewer than two observations)
+ */
+double SampleStatistics::getHalfWidth(double confidence) const {
+    if (count < 2) {
+        return numeric_limits<double>::infinity();
+    }
+    double t = studentQuantile(0.5 + confidence / 2, count - 1);
+    return t * sqrt(getVariance() / count);
+}
+
+/*
+ * Continued fraction of the regularized incomplete beta function
+ * (modified Lentz's method)
+ */
+static double betaContinuedFraction(double a, double b, double x) {
+    const double tiny = 1e-300;
+    double c = 1;
+    double d = 1 - (a + b) * x / (a + 1);
+    d = 1 / (fabs(d) < tiny ? tiny : d);
+    double result = d;
+    for (int m = 1; m <= 300; m++) {
+        double numerator = m * (b - m) * x / ((a + 2 * m - 1) * (a + 2 * m));
+        d = 1 + numerator * d;
+        c = 1 + numerator / c;
+        d = 1 / (fabs(d) < tiny ? tiny : d);
+        c = fabs(c) < tiny ? tiny : c;
+        result *= d * c;
+
+        numerator = -(a + m) * (a + b + m) * x / ((a + 2 * m) * (a + 2 * m + 1));
+        d = 1 + numerator * d;
+        c = 1 + numerator / c;
+        d = 1 / (fabs(d) < tiny ? tiny : d);
+        c = fabs(c) < tiny ? tiny : c;
+        double step = d * c;
+        result *= step;
+        if (fabs(step - 1) < 1e-15) {
+            break;
+        }
+    }
+    return result;
+}
+
+/*
+ * @return double regularized incomplete beta function I_x(a, b)
+ */
+static double incompleteBeta(double a, double b, double x) {
+    if (x <= 0) return 0;
+    if (x >= 1) return 1;
+    double front = exp(lgamma(a + b) - lgamma(a) - lgamma(b) + a * log(x) + b * log(1 - x));
+    if (x < (a + 1) / (a + b + 2)) {
+        return front * betaContinuedFraction(a, b, x) / a;
+    }
+    return 1 - front * betaContinuedFraction(b, a, 1 - x) / b;
+}
+
+/*
+ * @param double t
+ * @param int degreesOfFreedom
+ * @return double P(T <= t) for Student's t distribution
+ */
+static double studentDistribution(double t, int degreesOfFreedom) {
+    double tail = 0.5 * incompleteBeta(degreesOfFreedom / 2.0, 0.5,
+                                       degreesOfFreedom / (degreesOfFreedom + t * t));
+    return t >= 0 ? 1 - tail : tail;
+}
+
+/*
+ * Inverts Student's t distribution by bisection
+ * @param double probability in (0, 1), e.g. 0.975 for a 95% interval
+ * @param int degreesOfFreedom at least 1
+ * @return double t such that P(T <= t) = probability
+ */
+double SampleStatistics::studentQuantile(double probability, int degreesOfFreedom) {
+    if (probability < 0.5) {
+        return -studentQuantile(1 - probability, degreesOfFreedom);
+    }
+    double low = 0;
+    double high = 1;
+    while (studentDistribution(high, degreesOfFreedom) < probability && high < 1e12) {
+        high *= 2;
+    }
+    for (int i = 0; i < 100; i++) {
+        double middle = (low + high) / 2;
+        if (studentDistribution(middle, degreesOfFreedom) < probability) {
+            low = middle;
+        } else {
+            high = middle;
+        }
+    }
+    return (low + high) / 2;
+}
+
+#endif
@@ -0,0 +1,31 @@
+#ifndef __SAMPLE_STATISTICS_H__
+#define __SAMPLE_STATISTICS_H__
+
+using namespace std;
+
+/*
+ * Running mean and variance of a sample (Welford's method, one pass, no
+ * storage) and confidence intervals based on Student's t distribution
+ */
+class SampleStatistics {
+    private:
+        long count;
+        double mean;
+        double squares;     // sum of squared deviations from the mean
+
+    public:
+        SampleStatistics();
+
+        void add(double value);
+        void clear();
+
+        inline long getCount() const { return count; }
+        inline double getMean() const { return mean; }
+        double getVariance() const;
+        double getStandardDeviation() const;
+        double getHalfWidth(double confidence = 0.95) const;
+
+        static double studentQuantile(double probability, int degreesOfFreedom);
+};
+
+#endif
@@ -0,0 +1,236 @@
+#ifndef __SIM_CONFIG_CPP__
+#define __SIM_CONFIG_CPP__
+
+#include "SimConfig.h"
+#include "Vehicle.h"
+
+#include <algorithm>
+#include <fstream>
+#include <stdexcept>
+
+using namespace std;
+
+/*
+ * Reads "name value" pairs from an input file
+ * @param const string& file path of the input file
+ * @return SimConfig validated configuration
+ * @throws runtime_error if the file can't be read or a parameter is missing/invalid
+ */
+SimConfig SimConfig::fromFile(const string& file) {
+    ifstream infile {file};
+
+    if (!infile) {
+        throw runtime_error("Unable to open file: " + file);
+    }
+
+    string paramName;
+    double paramValue;
+
+    map<string, double> parameters;
+
+    while (infile >> paramName) {
+        if (!(infile >> paramValue)) {
+            throw runtime_error("Invalid value for parameter " + paramName + " in " + file);
+        }
+        parameters[paramName] = paramValue;
+    }
+
+    return fromParameters(parameters);
+}
+
+/*
+ * Builds a configuration from an in-memory parameter map. Names may be given
+ * with or without the trailing ':' used in input files.
+ * @param const map<string, double>& parameters
+ * @return SimConfig validated configuration
+ * @throws runtime_error if a parameter is missing or invalid
+ */
+SimConfig SimConfig::fromParameters(const map<string, double>& parameters) {
+    SimConfig config;
+
+    for (auto& parameter : parameters) {
+        config.parameters[normalizeName(parameter.first)] = parameter.second;
+    }
+
+    config.simTime = config.require("maximum_simulated_time");
+    config.roadLen = config.require("number_of_sections_before_intersection");
+    config.greenNS = config.require("green_north_south");
+    config.yellowNS = config.require("yellow_north_south");
+    config.greenEW = config.require("green_east_west");
+    config.yellowEW = config.require("yellow_east_west");
+    config.probNB = config.require("prob_new_vehicle_northbound");
+    config.probSB = config.require("prob_new_vehicle_southbound");
+    config.probEB = config.require("prob_new_vehicle_eastbound");
+    config.probWB = config.require("prob_new_vehicle_westbound");
+    config.proportionCars = config.require("proportion_of_cars");
+    config.proportionSUVs = config.require("proportion_of_SUVs");
+    config.proportionCarRight = config.require("proportion_right_turn_cars");
+    config.proportionCarLeft = config.require("proportion_left_turn_cars");
+    config.proportionSUVRight = config.require("proportion_right_turn_SUVs");
+    config.proportionSUVLeft = config.require("proportion_left_turn_SUVs");
+    config.proportionTruckRight = config.require("proportion_right_turn_trucks");
+    config.proportionTruckLeft = config.require("proportion_left_turn_trucks");
+
+    config.entryQueueCapacity = config.optional("entry_queue_capacity", 1024);
+    config.poissonArrivals = config.optional("poisson_arrivals", 0) != 0;
+    config.maxSpeed = config.optional("max_speed", 1);
+    config.slowdownProbability = config.optional("slowdown_probability", 0);
+    config.pairedRandomStreams = config.optional("paired_random_streams", 0) != 0;
+    config.stallTicks = config.optional("stall_ticks", 0);
+    config.readVehicleClasses();
+
+    config.validate();
+
+    return config;
+}
+
+/*
+ * Strips the trailing ':' used in input files from a parameter name
+ * @param const string& name
+ * @return string normalized name
+ */
+string SimConfig::normalizeName(const string& name) {
+    if (!name.empty() && name.back() == ':') {
+        return name.substr(0, name.size() - 1);
+    }
+    return name;
+}
+
+/*
+ * @param const string& name normalized parameter name
+ * @return double value of the parameter
+ * @throws runtime_error if the parameter was not given
+ */
+double SimConfig::require(const string& name) const {
+    auto it = parameters.find(name);
+    if (it == parameters.end()) {
+        throw runtime_error("Missing parameter: " + name);
+    }
+    return it->second;
+}
+
+/*
+ * @param const string& name normalized parameter name
+ * @param double defaultValue value used when the parameter was not given
+ * @return double value of the parameter
+ */
+double SimConfig::optional(const string& name, double defaultValue) const {
+    auto it = parameters.find(name);
+    return it == parameters.end() ? defaultValue : it->second;
+}
+
+/*
+ * Builds the vehicle class table: cars, SUVs and trucks, whose lengths can be
+ * changed with vehicle_class_cars, vehicle_class_SUVs and vehicle_class_trucks,
+ * then one class per other "vehicle_class_<name> length" parameter, in name
+ * order, each with proportion_of_<name>, proportion_right_turn_<name> and
+ * proportion_left_turn_<name>
+ * @throws runtime_error if a parameter of a declared class is missing
+ */
+void SimConfig::readVehicleClasses() {
+    static const string PREFIX = "vehicle_class_";
+
+    vehicleClasses = {
+        {"cars", Vehicle::lengthOf(VehicleType::car), proportionCars, proportionCarRight, proportionCarLeft},
+        {"SUVs", Vehicle::lengthOf(VehicleType::suv), proportionSUVs, proportionSUVRight, proportionSUVLeft},
+        {"trucks", Vehicle::lengthOf(VehicleType::truck), 0, proportionTruckRight, proportionTruckLeft}};
+    double others = proportionCars + proportionSUVs;
+
+    // parameters are sorted by name
+    for (const auto& parameter : parameters) {
+        if (parameter.first.compare(0, PREFIX.size(), PREFIX) != 0) {
+            continue;
+        }
+        string name = parameter.first.substr(PREFIX.size());
+        int length = parameter.second;
+        if (name.empty()) {
+            throw runtime_error("vehicle_class_ must be followed by the name of the class");
+        }
+
+        auto known = find_if(vehicleClasses.begin(), vehicleClasses.begin() + 3,
+                             [&name](const VehicleClass& vehicleClass) { return vehicleClass.name == name; });
+        if (known != vehicleClasses.begin() + 3) {
+            known->length = length;
+            continue;
+        }
+        vehicleClasses.push_back(VehicleClass{name, length, require("proportion_of_" + name),
+                                              require("proportion_right_turn_" + name),
+                                              require("proportion_left_turn_" + name)});
+        others += vehicleClasses.back().proportion;
+    }
+
+    vehicleClasses[static_cast<int>(VehicleType::truck)].proportion = max(0.0, 1 - others);
+}
+
+/*
+ * @return int sections occupied by the longest vehicle class
+ */
+int SimConfig::getMaxVehicleLength() const {
+    int longest = 0;
+    for (const VehicleClass& vehicleClass : vehicleClasses) {
+        longest = max(longest, vehicleClass.length);
+    }
+    return longest;
+}
+
+/*
+ * Checks that the parameters describe a simulation the engine can run
+ * @throws runtime_error describing the first invalid parameter
+ */
+void SimConfig::validate() const {
+    if (simTime < 0) {
+        throw runtime_error("maximum_simulated_time must not be negative");
+    }
+    if (roadLen < 3) {
+        throw runtime_error("number_of_sections_before_intersection must be at least 3");
+    }
+    if (static_cast<int>(vehicleClasses.size()) > MAX_VEHICLE_CLASSES) {
+        throw runtime_error("at most " + to_string(MAX_VEHICLE_CLASSES) + " vehicle classes can be used");
+    }
+    for (const VehicleClass& vehicleClass : vehicleClasses) {
+        if (vehicleClass.length < 1) {
+            throw runtime_error("vehicle_class_" + vehicleClass.name + " must be at least 1");
+        }
+    }
+    // a right-turning vehicle of length L reaches section roadLen + L of its new bound
+    if (getMaxVehicleLength() > roadLen + 1) {
+        throw runtime_error("number_of_sections_before_intersection must be at least the longest vehicle minus 1");
+    }
+    if (greenNS < 0 || yellowNS < 0 || greenEW < 0 || yellowEW < 0) {
+        throw runtime_error("light durations must not be negative");
+    }
+    if (getLightCycle() <= 0) {
+        throw runtime_error("light cycle must be longer than 0");
+    }
+    if (entryQueueCapacity < 1) {
+        throw runtime_error("entry_queue_capacity must be at least 1");
+    }
+    if (maxSpeed < 1) {
+        throw runtime_error("max_speed must be at least 1");
+    }
+    if (slowdownProbability < 0 || slowdownProbability > 1) {
+        throw runtime_error("slowdown_probability must be between 0 and 1");
+    }
+    if (stallTicks < 0) {
+        throw runtime_error("stall_ticks must not be negative");
+    }
+
+    // with Poisson arrivals the rates may exceed one vehicle per tick
+    double rates[] = {probNB, probSB, probEB, probWB};
+    for (double rate : rates) {
+        if (rate < 0 || (rate > 1 && !poissonArrivals)) {
+            throw runtime_error("prob_new_vehicle_* must be between 0 and 1 (or a rate >= 0 with poisson_arrivals)");
+        }
+    }
+
+    for (const VehicleClass& vehicleClass : vehicleClasses) {
+        double probabilities[] = {vehicleClass.proportion, vehicleClass.proportionRight, vehicleClass.proportionLeft};
+        for (double probability : probabilities) {
+            if (probability < 0 || probability > 1) {
+                throw runtime_error("probabilities and proportions must be between 0 and 1");
+            }
+        }
+    }
+}
+
+#endif
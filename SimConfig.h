@@ -0,0 +1,80 @@
+#ifndef __SIM_CONFIG_H__
+#define __SIM_CONFIG_H__
+
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// A kind of vehicle: cars, SUVs and trucks, then the classes declared in the input file
+struct VehicleClass {
+    string name;            // suffix of its proportion_* parameters, e.g. "cars" or "bus"
+    int length;             // sections occupied
+    double proportion;      // share of the arrivals (trucks take whatever the others leave)
+    double proportionRight;
+    double proportionLeft;
+};
+
+/*
+ * Parsed and validated simulation parameters. A SimConfig can be read from an
+ * input file (see input_file_format.txt) or built from an in-memory map, so the
+ * same configuration can be reused for many Simulator instances without
+ * touching the disk again. Parameter names are normalized (no trailing ':').
+ * Invalid or missing parameters are reported by throwing runtime_error.
+ */
+class SimConfig {
+    private:
+        map<string, double> parameters;
+
+        double require(const string& name) const;
+        double optional(const string& name, double defaultValue) const;
+        void readVehicleClasses();
+        void validate() const;
+
+    public:
+        static const int MAX_VEHICLE_CLASSES = 16;
+
+        int simTime;
+        int roadLen;
+        int greenNS;
+        int yellowNS;
+        int greenEW;
+        int yellowEW;
+        double probNB;
+        double probSB;
+        double probEB;
+        double probWB;
+        double proportionCars;
+        double proportionSUVs;
+        double proportionCarRight;
+        double proportionCarLeft;
+        double proportionSUVRight;
+        double proportionSUVLeft;
+        double proportionTruckRight;
+        double proportionTruckLeft;
+
+        // Optional parameters
+        int entryQueueCapacity;     // vehicles that can wait off the map per bound
+        bool poissonArrivals;       // prob_new_vehicle_* are Poisson rates per tick
+        int maxSpeed;               // sections per tick away from the intersection
+        double slowdownProbability; // chance a vehicle brakes by one section per tick
+        bool pairedRandomStreams;   // arrivals, types and turns drawn from per-bound streams
+        int stallTicks;             // ticks with a vehicle held at the stop line and none entering or clearing the intersection
+                                    // while vehicles wait before the run is aborted (0: never)
+        vector<VehicleClass> vehicleClasses;    // indexed by VehicleType
+
+        inline bool isCellular() const { return maxSpeed > 1 || slowdownProbability > 0; }
+
+        static SimConfig fromFile(const string& file);
+        static SimConfig fromParameters(const map<string, double>& parameters);
+
+        static string normalizeName(const string& name);
+
+        int getMaxVehicleLength() const;
+
+        inline int getLightCycle() const { return greenNS + yellowNS + greenEW + yellowEW; }
+        inline const map<string, double>& getParameters() const { return parameters; }
+};
+
+#endif
@@ -5,164 +5,402 @@
 #include "Vehicle.h"
 #include "VehicleBase.h"
 #include "Animator.h"
+#include "AllocationTracker.h"
 
 #include <iostream>
-#include <fstream>
 #include <vector>
 #include <string>
 #include <map>
+#include <sstream>
+#include <set>
+#include <stdexcept>
 #include <algorithm>
 #include <random>
+#include <cmath>
 
 using namespace std;
 
-Simulator::Simulator(string file, int seed) {
+/*
+ * Reads the configuration from an input file
+ * @param string file path of the input file
+ * @param int seed seed of the random number generator
+ * @throws runtime_error if the file can't be read or holds invalid parameters
+ */
+Simulator::Simulator(string file, int seed) : Simulator(SimConfig::fromFile(file), seed) {}
+
+/*
+ * Builds a simulator from an already parsed configuration
+ * @param const SimConfig& config
+ * @param int seed seed of the random number generator
+ * @param shared_ptr<const AdmissionTable> admission stop-line table built from the same
+ * configuration, shared with other simulators (built here if nullptr)
+ */
+Simulator::Simulator(const SimConfig& config, int seed, shared_ptr<const AdmissionTable> admission)
+        : config(config), laneEngine(LaneEngine::automatic), rand_double(0, 1), rand_poisson(1),
+          admission(admission), arrivalCursor(0), releasedCursor(0), arrivalPending(false) {
+    applyConfig();
+    if (!this->admission) {
+        this->admission = make_shared<const AdmissionTable>(config);
+    }
+    reset(seed);
+}
+
+/*
+ * Copies the configuration values into the fields used by the simulation loop
+ */
+void Simulator::applyConfig() {
+    simTime = config.simTime;
+    roadLen = config.roadLen;
+    greenNS = config.greenNS;
+    yellowNS = config.yellowNS;
+    greenEW = config.greenEW;
+    yellowEW = config.yellowEW;
+    poissonArrivals = config.poissonArrivals;
+    pairedRandomStreams = config.pairedRandomStreams;
+    stallTicks = config.stallTicks;
+    cellular = config.isCellular();
+    maxSpeed = config.maxSpeed;
+    slowdownProbability = config.slowdownProbability;
+
+    lightCycle = config.getLightCycle();
+
+    // one section per tick; the cellular model saves ticks on the approach
+    // (from before section 0 to the stop line) and after the intersection
+    // (back from roadLen + 3, at speed 1 when leaving it, past the last section)
+    freeFlowBase = roadLen * 2 + 2;
+    if (cellular) {
+        freeFlowBase -= roadLen - freeRunTicks(-1, roadLen - 1, 0);
+        freeFlowBase -= roadLen - 2 - freeRunTicks(roadLen + 3, roadLen * 2 + 1, 1);
+    }
 
+    // the profile is sampled once here, never during the run
+    demand = make_shared<const DemandTable>(config, demandProfile.get());
+}
+
+/*
+ * Restarts the simulation from time 0 with the same seed
+ */
+void Simulator::reset() {
+    reset(seed);
+}
+
+/*
+ * Restarts the simulation from time 0: removes all vehicles, empties the lanes,
+ * resets the lights and the section reservations and reseeds the generator
+ * @param int seed new seed of the random number generator
+ */
+void Simulator::reset(int seed) {
     this->seed = seed;
+    randomNumberGenerator.seed(seed);
+    rand_double.reset();
+
+    // random braking has its own stream so it doesn't shift the arrivals
+    seed_seq slowdownSeed {seed, 1};
+    slowdownGenerator.seed(slowdownSeed);
+
+    for (int bound = 0; bound < 4; bound++) {
+        seed_seq arrivalSeed {seed, 2, bound};
+        arrivalGenerators[bound].seed(arrivalSeed);
+        seed_seq vehicleSeed {seed, 3, bound};
+        vehicleGenerators[bound].seed(vehicleSeed);
+    }
 
-    ifstream infile {file};
+    // every vehicle on the map holds at least one section (plus one waiting per
+    // bound), so for roads of usual length the vector never has to grow
+    vehicles.clear();
+    vehicles.reserve(min(4 * (roadLen * 2 + 3), MAX_RESERVED_VEHICLES));
+    nextVehicleID = 0;
+    droppedSpawns = 0;
+    statistics = RunStatistics{0, 0, 0, 0, 0, 0, 0};
+    heldTicks = 0;
+    stalled = false;
+
+    for (int bound = 0; bound < 4; bound++) {
+        entryQueues[bound] = EntryQueue(config.entryQueueCapacity);
+        entryWaiting[bound] = -1;
+    }
+    currentTime = 0;
+    demandLevel = &demand->at(0);
 
-    if (!infile) {
-        cerr << "Unable to open file: " << file << endl;
-        exit(0);
+    if (arrivalLog) {
+        arrivalCursor = arrivalLog->begin();
+        releasedCursor = arrivalCursor;
+        arrivalPending = arrivalLog->next(arrivalCursor, nextArrival);
     }
 
-    string paramName;
-    double paramValue;
+    // construct the lanes of appropriate size, init to nullptr
+    initLanes();
+
+    // at most one vehicle per section approaches a stop line, so the
+    // cellular-automaton arrays never have to grow
+    if (cellular) {
+        int laneCapacity = min(roadLen + 1, MAX_RESERVED_VEHICLES);
+        for (CellularLane& lane : cellularLanes) {
+            lane.index.reserve(laneCapacity);
+            lane.front.reserve(laneCapacity);
+            lane.back.reserve(laneCapacity);
+            lane.length.reserve(laneCapacity);
+            lane.speed.reserve(laneCapacity);
+            lane.brake.reserve(laneCapacity);
+            lane.limit.reserve(laneCapacity);
+        }
+        cellularMoved.reserve(vehicles.capacity());
+    }
 
-    map<string, double> parameters;
+    // durations given to retime() apply from time 0 on a restart
+    if (pendingAdmission) {
+        admission = pendingAdmission;
+        lightCycle = pendingLightCycle;
+        pendingAdmission = nullptr;
+    }
+    cycleStart = 0;
+    cyclePosition = 0;
+    lightNSState = LightColor::green;
+    lightEWState = LightColor::red;
+
+    NESec = 0;
+    NWSec = 0;
+    SESec = 0;
+    SWSec = 0;
+}
 
-    while (!infile.eof()) {
-        infile >> paramName;
-        infile >> paramValue;
-        parameters[paramName] = paramValue;
+/*
+ * Chooses the lane storage: fixed-size arrays when the road length has a
+ * compiled specialization (10, 20 or 50 sections), per-vehicle spans for very
+ * long roads, vectors otherwise
+ */
+void Simulator::initLanes() {
+    if (laneEngine == LaneEngine::queue ||
+            (laneEngine == LaneEngine::automatic && roadLen >= QUEUE_LANES_MIN_ROAD_LENGTH)) {
+        roadLanes.emplace<QueueLanes>(roadLen);
+    } else if (laneEngine == LaneEngine::automatic && roadLen == 10) {
+        roadLanes.emplace<FixedLanes<10>>();
+    } else if (laneEngine == LaneEngine::automatic && roadLen == 20) {
+        roadLanes.emplace<FixedLanes<20>>();
+    } else if (laneEngine == LaneEngine::automatic && roadLen == 50) {
+        roadLanes.emplace<FixedLanes<50>>();
+    } else {
+        roadLanes.emplace<DynamicLanes>(roadLen);
     }
+}
 
-    simTime = parameters["maximum_simulated_time:"];
-    roadLen = parameters["number_of_sections_before_intersection:"];
-    greenNS = parameters["green_north_south:"];
-    yellowNS = parameters["yellow_north_south:"];
-    greenEW = parameters["green_east_west:"];
-    yellowEW = parameters["yellow_east_west:"];
-    probNB = parameters["prob_new_vehicle_northbound:"];
-    probSB = parameters["prob_new_vehicle_southbound:"];
-    probEB = parameters["prob_new_vehicle_eastbound:"];
-    probWB = parameters["prob_new_vehicle_westbound:"];
-    proportionCars = parameters["proportion_of_cars:"];
-    proportionSUVs = parameters["proportion_of_SUVs:"];
-    proportionCarRight = parameters["proportion_right_turn_cars:"];
-    proportionCarLeft = parameters["proportion_left_turn_cars:"];
-    proportionSUVRight = parameters["proportion_right_turn_SUVs:"];
-    proportionSUVLeft = parameters["proportion_left_turn_SUVs:"];
-    proportionTruckRight = parameters["proportion_right_turn_trucks:"];
-    proportionTruckLeft = parameters["proportion_left_turn_trucks:"];
+/*
+ * Switches to another configuration and restarts the simulation (same seed),
+ * keeping the lane storage choice and the memory already reserved
+ * @param const SimConfig& config
+ * @param shared_ptr<const AdmissionTable> admission table built from the same
+ * configuration (built here if nullptr)
+ */
+void Simulator::setConfig(const SimConfig& config, shared_ptr<const AdmissionTable> admission) {
+    this->config = config;
+    applyConfig();
+    this->admission = admission ? admission : make_shared<const AdmissionTable>(config);
+    pendingAdmission = nullptr;
+    reset();
+}
 
-    lightCycle = greenEW + yellowEW + greenNS + yellowNS;
+/*
+ * Switches to other light durations (or another end time) without restarting.
+ * The running cycle is finished with the current durations and the new ones
+ * start at its end, the way a signal controller changes plans, so the lights
+ * only change as they would between two cycles.
+ * @param const SimConfig& config differs from the current configuration only
+ * in the light durations and maximum_simulated_time
+ * @param shared_ptr<const AdmissionTable> admission table built from config
+ * (built here if nullptr)
+ * @throws runtime_error if another parameter differs
+ */
+void Simulator::retime(const SimConfig& config, shared_ptr<const AdmissionTable> admission) {
+    string changed = changedParameter(this->config, config, isRetimable);
+    if (!changed.empty()) {
+        throw runtime_error("Only the light durations and maximum_simulated_time can change during a run: " + changed);
+    }
 
-    // construct vectors of VehicleBase* of appropriate size, init to nullptr
-    westbound.resize(roadLen * 2 + 2);
-    eastbound.resize(roadLen * 2 + 2);
-    southbound.resize(roadLen * 2 + 2);
-    northbound.resize(roadLen * 2 + 2);
-    
+    // first tick at or after now where the running cycle starts over (a plan
+    // still pending is replaced, its switch time depends on the running cycle only)
+    int elapsed = currentTime - cycleStart;
+    planSwitchTime = cycleStart + (elapsed + lightCycle - 1) / lightCycle * lightCycle;
+    pendingLightCycle = config.getLightCycle();
+    pendingAdmission = admission ? admission : make_shared<const AdmissionTable>(config);
+
+    bool timeChanged = config.simTime != simTime;
+    this->config = config;
+    simTime = config.simTime;
+    greenNS = config.greenNS;
+    yellowNS = config.yellowNS;
+    greenEW = config.greenEW;
+    yellowEW = config.yellowEW;
+
+    // a profile without a period is spread over the whole run
+    if (timeChanged && demandProfile) {
+        demand = make_shared<const DemandTable>(config, demandProfile.get());
+        demandLevel = &demand->at(currentTime);
+    }
 }
 
-void Simulator::runSimulation() {
+/*
+ * Switches to other arrival rates and type and turn proportions without
+ * restarting: the arrivals of the next tick are drawn with them (a demand
+ * profile, if any, still gives the parameters it has breakpoints for)
+ * @param const SimConfig& config differs from the current configuration only
+ * in the prob_new_vehicle_* and proportion_* parameters
+ * @throws runtime_error if another parameter differs
+ */
+void Simulator::redemand(const SimConfig& config) {
+    string changed = changedParameter(this->config, config, isDemandParameter);
+    if (!changed.empty()) {
+        throw runtime_error("Only the arrival rates and proportions can change with the demand: " + changed);
+    }
+    shared_ptr<const DemandTable> table = make_shared<const DemandTable>(config, demandProfile.get());
+    this->config = config;
+    demand = table;
+    demandLevel = &demand->at(currentTime);
+}
+
+/*
+ * @param const string& name normalized parameter name
+ * @return bool true for the parameters retime() may change
+ */
+bool Simulator::isRetimable(const string& name) {
+    static const set<string> retimable = {"green_north_south", "yellow_north_south", "green_east_west",
+                                          "yellow_east_west", "maximum_simulated_time"};
+    return retimable.count(name) > 0;
+}
+
+/*
+ * @param const string& name normalized parameter name
+ * @return bool true for the parameters redemand() may change
+ */
+bool Simulator::isDemandParameter(const string& name) {
+    return name.compare(0, 17, "prob_new_vehicle_") == 0 || name.compare(0, 11, "proportion_") == 0;
+}
+
+/*
+ * @param const SimConfig& current
+ * @param const SimConfig& next
+ * @param bool (*allowed)(const string&) parameters that may differ
+ * @return string first other parameter that differs (or is only in one of
+ * them), empty if none
+ */
+string Simulator::changedParameter(const SimConfig& current, const SimConfig& next,
+                                   bool (*allowed)(const string&)) {
+    const map<string, double>& before = current.getParameters();
+    const map<string, double>& after = next.getParameters();
+    for (const auto& parameter : before) {
+        auto other = after.find(parameter.first);
+        if (!allowed(parameter.first) && (other == after.end() || other->second != parameter.second)) {
+            return parameter.first;
+        }
+    }
+    for (const auto& parameter : after) {
+        if (before.count(parameter.first) == 0) {
+            return parameter.first;
+        }
+    }
+    return "";
+}
+
+/*
+ * Makes the arrival rates and the type and turn proportions follow a demand
+ * profile and restarts the simulation (same seed)
+ * @param shared_ptr<const DemandProfile> profile nullptr for the constant demand
+ * of the configuration
+ * @throws runtime_error if the profile gives a value out of range
+ */
+void Simulator::setDemandProfile(shared_ptr<const DemandProfile> profile) {
+    shared_ptr<const DemandTable> table = make_shared<const DemandTable>(config, profile.get());
+    demandProfile = profile;
+    demand = table;
+    reset();
+}
+
+/*
+ * Replays recorded arrivals instead of drawing random ones and restarts the
+ * simulation (same seed)
+ * @param shared_ptr<const ArrivalLog> log nullptr to go back to random arrivals
+ */
+void Simulator::setArrivalLog(shared_ptr<const ArrivalLog> log) {
+    arrivalLog = log;
+    arrivalPending = false;
+    reset();
+}
+
+/*
+ * Counts the sections held in every following tick (without restarting)
+ * @param shared_ptr<OccupancyMap> map built for the road length of the
+ * configuration, or nullptr to stop counting
+ * @throws runtime_error if the map was built for another road length
+ */
+void Simulator::setOccupancyMap(shared_ptr<OccupancyMap> map) {
+    if (map && map->getRoadLen() != roadLen) {
+        throw runtime_error("Occupancy map built for another road length");
+    }
+    occupancy = map;
+}
 
-    mt19937 randomNumberGenerator; // Mersenne twister
-    uniform_real_distribution<double> rand_double(0, 1);
+/*
+ * Selects the lane storage and restarts the simulation (same seed)
+ * @param LaneEngine engine automatic (chosen from the road length), dynamic or queue
+ */
+void Simulator::setLaneEngine(LaneEngine engine) {
+    laneEngine = engine;
+    reset();
+}
 
-    randomNumberGenerator.seed(this->seed);
+/*
+ * @return string name of the lane storage in use, e.g. "fixed<20>", "dynamic" or "queue"
+ */
+string Simulator::getLaneEngineName() const {
+    return visit([](const auto& lanes) { return lanes.getName(); }, roadLanes);
+}
 
-    //Null vector to re-initialize
-    vector<VehicleBase*> nullVector(roadLen * 2 + 2, nullptr);
+/*
+ * @return string what the intersection looked like when the run was aborted
+ * for a stall (empty if it wasn't)
+ */
+string Simulator::describeStall() const {
+    if (!stalled) {
+        return "";
+    }
+    static const char* LIGHT_NAMES[] = {"green", "yellow", "red"};
+    ostringstream text;
+    text << "stalled at tick " << currentTime - 1 << ": vehicles held at the stop line for " << heldTicks
+         << " ticks while none entered or cleared the intersection; " << vehicles.size()
+         << " vehicles on the road, queues "
+         << entryQueues[0].size() << "/" << entryQueues[1].size() << "/" << entryQueues[2].size() << "/"
+         << entryQueues[3].size() << " (north/south/east/west), lights north-south "
+         << LIGHT_NAMES[static_cast<int>(lightNSState)] << " east-west " << LIGHT_NAMES[static_cast<int>(lightEWState)]
+         << ", reservations NE/NW/SE/SW " << NESec << "/" << NWSec << "/" << SESec << "/" << SWSec;
+    return text.str();
+}
 
-    // construct vectors of VehicleBase* of appropriate size, init to nullptr
-    westbound.assign(nullVector.begin(), nullVector.end());
-    eastbound.assign(nullVector.begin(), nullVector.end());
-    southbound.assign(nullVector.begin(), nullVector.end());
-    northbound.assign(nullVector.begin(), nullVector.end());
+/*
+ * Runs the whole simulation in the terminal, drawing every tick and waiting
+ * for a key press before the next one
+ */
+void Simulator::runSimulation() {
 
-    vector<vector<VehicleBase*>*> allBounds {&northbound, &westbound, &southbound, &eastbound};
+    reset();
 
     char dummy;
 
     Animator anim(roadLen);
 
-    string lightNSState = "green";
-    int NSTimeToRed = greenNS + yellowNS;
-
-    string lightEWState = "red";
-    int EWTimeToRed = 0; 
-
-    // Section checks
-    int NESec = 0;
-    int NWSec = 0;
-    int SESec = 0;
-    int SWSec = 0;
-
-
-    for (int i = 0; i < simTime; i++) {
-        // Clearing the Lanes
-        westbound.assign(nullVector.begin(), nullVector.end());
-        eastbound.assign(nullVector.begin(), nullVector.end());
-        southbound.assign(nullVector.begin(), nullVector.end());
-        northbound.assign(nullVector.begin(), nullVector.end());
-
-        // Creating vehicles to add
-        addVehicle(northbound, Direction::north, probNB, rand_double(randomNumberGenerator), rand_double(randomNumberGenerator), rand_double(randomNumberGenerator));
-        addVehicle(southbound, Direction::south, probSB, rand_double(randomNumberGenerator), rand_double(randomNumberGenerator), rand_double(randomNumberGenerator));
-        addVehicle(eastbound, Direction::east, probEB, rand_double(randomNumberGenerator), rand_double(randomNumberGenerator), rand_double(randomNumberGenerator));
-        addVehicle(westbound, Direction::west, probWB, rand_double(randomNumberGenerator), rand_double(randomNumberGenerator), rand_double(randomNumberGenerator));
-
-        // Setting the lights
-        setLights(i, anim, lightNSState, NSTimeToRed, lightEWState, EWTimeToRed);
-
-
-        for (auto& vehicle : vehicles) {
-            // Past Transition Vehicles
-            if (vehicle.getBackIndex()  > roadLen + 2) {
-                moveStraight(vehicle);
-            // During Transition
-            } else if (vehicle.getInTransition() && vehicle.getTurn() == TurnType::right) {
-                moveTransition(vehicle, allBounds);
-            } else if (vehicle.getInTransition() && vehicle.getTurn() == TurnType::left) {
-                moveTransitionLeft(vehicle, allBounds);
-            // Vehicle right before getting into the transition: 
-            } else if (vehicle.getFrontIndex() + 1 == roadLen) {
-                if (checkLight(vehicle, lightNSState, lightEWState) && 
-                        checkMove(vehicle, NSTimeToRed, EWTimeToRed) && 
-                        clearPathTransition(vehicle, NESec, NWSec, SESec, SWSec)) {
-                    moveStraight(vehicle);
-                    if (vehicle.getTurn() != TurnType::straight) {
-                        vehicle.setTransition(true);
-                    }
-                //Vehicle can't move forward
-                } else {
-                    printVehicle(vehicle);
-                }
-            } else {
-                //Vehicle moving in straight line at the beginning
-                if (clearPath(vehicle)) {
-                    moveStraight(vehicle);
-                } else {
-                    printVehicle(vehicle);
-                }
-            }
-        }
+    while (!isFinished()) {
+        int i = currentTime;
+        step();
 
-        // Regulating the section reservations
-        NESec = max(0, NESec-1);
-        NWSec = max(0, NWSec-1);
-        SESec = max(0, SESec-1);
-        SWSec = max(0, SWSec-1);
+        AllocationSite site("Animator::render");
 
         // Setting up the animation
+        anim.setLightNorthSouth(lightNSState);
+        anim.setLightEastWest(lightEWState);
+
         // Adding the bounds in the animations
-        anim.setVehiclesNorthbound(northbound);
-        anim.setVehiclesWestbound(westbound);
-        anim.setVehiclesSouthbound(southbound);
-        anim.setVehiclesEastbound(eastbound);
+        anim.setVehiclesNorthbound(getLane(Direction::north));
+        anim.setVehiclesWestbound(getLane(Direction::west));
+        anim.setVehiclesSouthbound(getLane(Direction::south));
+        anim.setVehiclesEastbound(getLane(Direction::east));
 
         // Drawing the Animation
         anim.draw(i);
@@ -172,61 +410,374 @@ void Simulator::runSimulation() {
     }
 }
 
+/*
+ * Advances the simulation without drawing or reading input
+ * @param int ticks number of ticks to simulate
+ * @return int number of ticks actually simulated (stops at maximum_simulated_time)
+ */
+int Simulator::step(int ticks) {
+
+    int simulated = 0;
+
+    for (; simulated < ticks && !isFinished(); simulated++) {
+        visit([this](auto& lanes) { tick(lanes); }, roadLanes);
+    }
+
+    return simulated;
+}
 
 /*
- * Creates vehicles using given probabilites and add them to vector vehicles 
- * @param vector<VehicleBase*>& bound; vector storing all bounds
- * @param Direction direction the bound to which a vehicle will be added
- * @param double inputLaneProb the probability of a vehicle appearing in a given bound
- * @param double spawnProb a randomly generated double which will determine whether a vehicle is created
- * @param double typeProba randomly generated number which will determine what type of vehicle is spawned
- * @param turnProb a randomly generated number which will determine what direction the behicle is going to turn
+ * Simulates one tick on the given lane storage
+ * @param Lanes& lanes the lanes held in roadLanes
  */
-void Simulator::addVehicle(vector<VehicleBase*>& bound, Direction direction, double inputLaneProb, double spawnProb, double typeProb, double turnProb) {
-    if (bound[0] == nullptr && spawnProb <= inputLaneProb) {
-        if (typeProb <= proportionCars) {
-            if (turnProb <= proportionCarRight) {
-                // create a right-turn car
-                vehicles.push_back(Vehicle(VehicleType::car, direction, TurnType::right));
-                return;
-            } else if (turnProb <= proportionCarRight + proportionCarLeft) {
-                // create a left-turn car
-                vehicles.push_back(Vehicle(VehicleType::car, direction, TurnType::left));
-                return;
-            } else {
-                // create a straight car
-                vehicles.push_back(Vehicle(VehicleType::car, direction, TurnType::straight));
-                return;
+template <class Lanes>
+void Simulator::tick(Lanes& lanes) {
+    AllocationSite site("Simulator::step");
+
+    // compile-time constant for FixedLanes
+    const int roadLen = lanes.getRoadLen();
+    int i = currentTime;
+    bool held = false;
+
+    // Forgetting the vehicles that left the map last tick
+    dropExitedVehicles();
+
+    // Clearing the Lanes
+    lanes.clear();
+
+    // Creating vehicles to add (they wait off the map in their bound's entry queue)
+    if (arrivalLog) {
+        replayArrivals();
+    } else {
+        demandLevel = &demand->at(i);
+        spawnVehicles(Direction::north, demandLevel->bounds[static_cast<int>(Direction::north)].arrival);
+        spawnVehicles(Direction::south, demandLevel->bounds[static_cast<int>(Direction::south)].arrival);
+        spawnVehicles(Direction::east, demandLevel->bounds[static_cast<int>(Direction::east)].arrival);
+        spawnVehicles(Direction::west, demandLevel->bounds[static_cast<int>(Direction::west)].arrival);
+    }
+
+    // Letting the first waiting vehicle of each bound onto the road
+    releaseVehicle(Direction::north);
+    releaseVehicle(Direction::south);
+    releaseVehicle(Direction::east);
+    releaseVehicle(Direction::west);
+
+    // Setting the lights
+    setLights(i);
+
+    // Multi-speed moves away from the intersection
+    if (cellular) {
+        moveCellular();
+    }
+
+    for (auto& vehicle : vehicles) {
+        // Already moved by the cellular-automaton model
+        if (cellular && cellularMoved[&vehicle - vehicles.data()]) {
+            if (vehicle.getSpeed() == 0 && vehicle.getFrontIndex() >= 0) {
+                countStoppedTick(vehicle);
             }
-        } else if (typeProb <= proportionCars + proportionSUVs) {
-            if (turnProb <= proportionSUVRight) {
-                vehicles.push_back(Vehicle(VehicleType::suv, direction, TurnType::right));
-                return;
-            } else if (turnProb <= proportionSUVRight + proportionSUVLeft) {
-                // create a left-turn SUV
-                vehicles.push_back(Vehicle(VehicleType::suv, direction, TurnType::left));
-                return;
+            printVehicle(vehicle, lanes);
+        // Past Transition Vehicles
+        } else if (vehicle.getBackIndex()  > roadLen + 2) {
+            moveStraight(vehicle, lanes);
+        // During Transition
+        } else if (vehicle.getInTransition()) {
+            moveTransition(vehicle, lanes);
+        // Vehicle right before getting into the transition: 
+        } else if (vehicle.getFrontIndex() + 1 == roadLen) {
+            if (admission->admits(cyclePosition, vehicle) && 
+                    clearPathTransition(vehicle, NESec, NWSec, SESec, SWSec)) {
+                moveStraight(vehicle, lanes);
+                vehicle.setEntryTick(currentTime);
+                heldTicks = 0;
+                // one section per tick through the intersection
+                vehicle.setSpeed(1);
+                if (vehicle.getTurn() != TurnType::straight) {
+                    vehicle.setTransition(true);
+                }
+            //Vehicle can't move forward
             } else {
-                // create a straight SUV
-                vehicles.push_back(Vehicle(VehicleType::suv, direction, TurnType::straight));
-                return;
+                held = true;
+                countStoppedTick(vehicle);
+                printVehicle(vehicle, lanes);
             }
         } else {
-            if (turnProb <= proportionTruckRight) {
-                // create a right-turn Truck
-                vehicles.push_back(Vehicle(VehicleType::truck, direction, TurnType::right));
-                return;
-            } else if (turnProb <= proportionTruckRight + proportionTruckLeft) {
-                // create a left-turn truck
-                vehicles.push_back(Vehicle(VehicleType::truck, direction, TurnType::left));
-                return;
+            //Vehicle moving in straight line at the beginning
+            if (clearPath(vehicle, lanes)) {
+                moveStraight(vehicle, lanes);
             } else {
-                // create a straight truck
-                vehicles.push_back(Vehicle(VehicleType::truck, direction, TurnType::straight));
-                return;
+                if (vehicle.getFrontIndex() >= 0) {
+                    countStoppedTick(vehicle);
+                }
+                printVehicle(vehicle, lanes);
+            }
+        }
+    }
+
+    // A released vehicle frees its bound's entry once it is on section 0
+    for (int& waiting : entryWaiting) {
+        if (waiting >= 0 && vehicles[waiting].getFrontIndex() >= 0) {
+            waiting = -1;
+        }
+    }
+
+    // Statistics: vehicles that left the map this tick (dropped next tick) and queues
+    for (const Vehicle& vehicle : vehicles) {
+        if (vehicle.getBackIndex() >= roadLen * 2 + 1) {
+            statistics.exited++;
+            statistics.totalTravelTime += currentTime + 1 - vehicle.getSpawnTick();
+            statistics.totalDelay += currentTime + 1 - vehicle.getSpawnTick() - freeFlowTicks(vehicle);
+            if (lifetimeWriter) {
+                lifetimeWriter->submit(LifetimeRecord{vehicle.getVehicleID(),
+                    static_cast<uint8_t>(vehicle.getVehicleType()),
+                    static_cast<uint8_t>(vehicle.getVehicleOriginalDirection()),
+                    static_cast<uint8_t>(vehicle.getTurn()), vehicle.getSpawnTick(),
+                    vehicle.getEntryTick(), currentTime, vehicle.getStoppedTicks()});
+            }
+        }
+    }
+    for (const EntryQueue& queue : entryQueues) {
+        statistics.queueLengthSum += queue.size();
+    }
+    statistics.ticks++;
+    if (occupancy) {
+        occupancy->addTick();
+    }
+
+    // Stall: for stallTicks ticks a vehicle waited at the stop line and none
+    // entered or cleared the intersection (vehicles still on their way don't count)
+    if (stallTicks > 0 && held && ++heldTicks >= stallTicks) {
+        stalled = true;
+        statistics.stalled = 1;
+    }
+
+    // Regulating the section reservations
+    NESec = max(0, NESec-1);
+    NWSec = max(0, NWSec-1);
+    SESec = max(0, SESec-1);
+    SWSec = max(0, SWSec-1);
+
+    currentTime++;
+}
+
+/*
+ * @param Direction direction
+ * @return LaneView sections of the bound after the last tick
+ */
+LaneView Simulator::getLane(Direction direction) const {
+    return visit([direction](const auto& lanes) { return lanes.view(direction); }, roadLanes);
+}
+
+
+/*
+ * Draws this tick's arrivals for a bound and puts them in its entry queue.
+ * Draws one Bernoulli trial per tick, or a Poisson number of vehicles when
+ * poisson_arrivals is set (rates above one vehicle per tick are allowed)
+ * @param Direction direction the bound receiving the vehicles
+ * @param double inputLaneProb the probability (or rate) of a vehicle appearing in the bound
+ */
+void Simulator::spawnVehicles(Direction direction, double inputLaneProb) {
+    if (pairedRandomStreams) {
+        spawnPairedVehicles(direction, inputLaneProb);
+    } else if (poissonArrivals) {
+        if (inputLaneProb <= 0) {
+            return;
+        }
+        int arrivals = rand_poisson(randomNumberGenerator, poisson_distribution<int>::param_type(inputLaneProb));
+        for (int k = 0; k < arrivals; k++) {
+            double typeProb = rand_double(randomNumberGenerator);
+            double turnProb = rand_double(randomNumberGenerator);
+            addVehicle(direction, typeProb, turnProb);
+        }
+    } else {
+        double turnProb = rand_double(randomNumberGenerator);
+        double typeProb = rand_double(randomNumberGenerator);
+        double spawnProb = rand_double(randomNumberGenerator);
+        if (spawnProb <= inputLaneProb) {
+            addVehicle(direction, typeProb, turnProb);
+        }
+    }
+}
+
+/*
+ * Draws this tick's arrivals for a bound from the bound's own streams: a single
+ * uniform number per tick decides the arrivals (by inversion, so a higher
+ * probability or rate only adds vehicles) and the k-th vehicle of the bound
+ * always gets the k-th type and turn draws
+ * @param Direction direction the bound receiving the vehicles
+ * @param double inputLaneProb the probability (or rate) of a vehicle appearing in the bound
+ */
+void Simulator::spawnPairedVehicles(Direction direction, double inputLaneProb) {
+    int bound = static_cast<int>(direction);
+    double arrivalProb = rand_double(arrivalGenerators[bound]);
+
+    int arrivals;
+    if (poissonArrivals) {
+        arrivals = poissonQuantile(arrivalProb, inputLaneProb);
+    } else {
+        arrivals = arrivalProb < inputLaneProb ? 1 : 0;
+    }
+
+    for (int k = 0; k < arrivals; k++) {
+        double typeProb = rand_double(vehicleGenerators[bound]);
+        double turnProb = rand_double(vehicleGenerators[bound]);
+        addVehicle(direction, typeProb, turnProb);
+    }
+}
+
+/*
+ * Ticks a vehicle alone on its bound takes to go from one section to another
+ * with the cellular model: it speeds up by one section per tick up to
+ * max_speed and never brakes
+ * @param int from section of the vehicle
+ * @param int to section to reach
+ * @param int speed speed before the first tick
+ * @return int
+ */
+int Simulator::freeRunTicks(int from, int to, int speed) const {
+    int ticks = 0;
+    for (; from < to; ticks++) {
+        speed = min(speed + 1, maxSpeed);
+        from += speed;
+    }
+    return ticks;
+}
+
+/*
+ * Travel time of the vehicle had it found its entry queue empty, green lights
+ * and nothing in its way: a longer vehicle takes one more tick to clear the
+ * last section, and a right turn enters its new bound one section further on
+ * @param const Vehicle& vehicle
+ * @return int ticks from arrival to leaving the map
+ */
+int Simulator::freeFlowTicks(const Vehicle& vehicle) const {
+    return freeFlowBase + vehicle.getLength() - (vehicle.getTurn() == TurnType::right ? 1 : 0);
+}
+
+/*
+ * Puts the recorded arrivals of this tick in the entry queues, in the order of
+ * the log (rows for earlier ticks, if the log isn't sorted, arrive now)
+ */
+void Simulator::replayArrivals() {
+    while (arrivalPending && nextArrival.tick <= currentTime) {
+        if (static_cast<size_t>(nextArrival.type) >= config.vehicleClasses.size()) {
+            throw runtime_error("Arrival log uses vehicle class " + to_string(static_cast<int>(nextArrival.type)) +
+                                ", which the configuration doesn't have");
+        }
+        enqueueVehicle(nextArrival.direction, nextArrival.type, nextArrival.turn);
+        arrivalPending = arrivalLog->next(arrivalCursor, nextArrival);
+    }
+    if (arrivalCursor - releasedCursor >= ARRIVAL_LOG_RELEASE_BYTES) {
+        arrivalLog->release(releasedCursor, arrivalCursor);
+        releasedCursor = arrivalCursor;
+    }
+}
+
+/*
+ * @param double probability
+ * @param double rate mean of the Poisson distribution
+ * @return int smallest k such that P(X <= k) >= probability
+ */
+int Simulator::poissonQuantile(double probability, double rate) {
+    if (rate <= 0) {
+        return 0;
+    }
+    double term = exp(-rate);
+    double cumulative = term;
+    int k = 0;
+    while (cumulative < probability && term > 0) {
+        k++;
+        term *= rate / k;
+        cumulative += term;
+    }
+    return k;
+}
+
+/*
+ * Creates a vehicle using given probabilites and adds it to the entry queue of its bound 
+ * (type and turn come from the cumulative thresholds of the current demand level)
+ * @param Direction direction the bound to which a vehicle will be added
+ * @param double typeProba randomly generated number which will determine what type of vehicle is spawned
+ * @param turnProb a randomly generated number which will determine what direction the behicle is going to turn
+ */
+void Simulator::addVehicle(Direction direction, double typeProb, double turnProb) {
+    const BoundDemand& bound = demandLevel->bounds[static_cast<int>(direction)];
+
+    // cars, then SUVs, then the configured classes, then trucks
+    VehicleType type = demand->typeOf(bound, typeProb);
+
+    // right, then left, then straight
+    const double* turnThresholds = bound.turnThresholds + 2 * static_cast<int>(type);
+    if (turnProb <= turnThresholds[0]) {
+        enqueueVehicle(direction, type, TurnType::right);
+    } else if (turnProb <= turnThresholds[1]) {
+        enqueueVehicle(direction, type, TurnType::left);
+    } else {
+        enqueueVehicle(direction, type, TurnType::straight);
+    }
+}
+
+/*
+ * Puts a new vehicle at the back of its bound's entry queue
+ * If the queue is full the arrival is dropped and counted
+ * @param Direction direction
+ * @param VehicleType type
+ * @param TurnType turn
+ */
+void Simulator::enqueueVehicle(Direction direction, VehicleType type, TurnType turn) {
+    EntryQueue& queue = entryQueues[static_cast<int>(direction)];
+    if (queue.full()) {
+        droppedSpawns++;
+        return;
+    }
+    queue.push(PendingVehicle{nextVehicleID++, currentTime, type, turn});
+    statistics.arrivals++;
+}
+
+/*
+ * Moves the first waiting vehicle of a bound to the vehicles vector (before section 0)
+ * unless the previously released vehicle has not entered the road yet
+ * @param Direction direction
+ */
+void Simulator::releaseVehicle(Direction direction) {
+    int bound = static_cast<int>(direction);
+    if (entryWaiting[bound] >= 0 || entryQueues[bound].empty()) {
+        return;
+    }
+    AllocationSite site("Simulator::releaseVehicle");
+    PendingVehicle pending = entryQueues[bound].pop();
+    vehicles.push_back(Vehicle(pending.type, direction, pending.turn, pending.id,
+                               config.vehicleClasses[static_cast<int>(pending.type)].length));
+    vehicles.back().setSpawnTick(pending.spawnTick);
+    entryWaiting[bound] = vehicles.size() - 1;
+}
+
+/*
+ * Removes the vehicles that are entirely past the last section. They no longer
+ * interact with anything, so the others keep their order and their moves;
+ * this keeps the vehicles vector at the size of the traffic on the map.
+ * Must run before the lanes are painted (it moves vehicles in memory)
+ */
+void Simulator::dropExitedVehicles() {
+    AllocationSite site("Simulator::dropExitedVehicles");
+    int maxIndex = roadLen * 2 + 1;
+    int kept = 0;
+
+    for (int k = 0; k < static_cast<int>(vehicles.size()); k++) {
+        if (vehicles[k].getBackIndex() >= maxIndex) {
+            continue;
+        }
+        if (kept != k) {
+            for (int& waiting : entryWaiting) {
+                if (waiting == k) {
+                    waiting = kept;
+                }
             }
+            vehicles[kept] = move(vehicles[k]);
         }
+        kept++;
     }
+    vehicles.erase(vehicles.begin() + kept, vehicles.end());
 }
 
 /*
@@ -234,9 +785,12 @@ void Simulator::addVehicle(vector<VehicleBase*>& bound, Direction direction, dou
  * Doesn't check for any condition: if the road ahead is clear or not
  * Uses printVehicle method
  * @param Vehicle& vhehicle
+ * @param Lanes& lanes
  */
-void Simulator::moveStraight(Vehicle& vehicle){
+template <class Lanes>
+void Simulator::moveStraight(Vehicle& vehicle, Lanes& lanes){
 
+    const int roadLen = lanes.getRoadLen();
     int vehicleLength = vehicle.getLength();
     int maxIndex = roadLen * 2 + 1;
 
@@ -247,107 +801,88 @@ void Simulator::moveStraight(Vehicle& vehicle){
     } else {
         vehicle.setBackIndex(vehicle.getBackIndex() + 1);
         vehicle.setFrontIndex(min(maxIndex, (vehicle.getBackIndex() + vehicleLength)));
+        // clear of the intersection
+        if (vehicle.getBackIndex() == roadLen + 1) {
+            heldTicks = 0;
+        }
     }
-    printVehicle(vehicle);
+    printVehicle(vehicle, lanes);
 }
 
 
 /*
  * Places the vehicle in its own bound based on its FrontIndex and BackIndex and currDirection
  * @param Vehicle& vehicle
+ * @param Lanes& lanes
  */
-void Simulator::printVehicle(Vehicle& vehicle){
-    if (vehicle.getDirection() == Direction::north){
-        for (int i = vehicle.getFrontIndex(); i > vehicle.getBackIndex(); i--) {
-            northbound[i] = &vehicle;
-        }
-    } else if (vehicle.getDirection() == Direction::east){
-        for (int i = vehicle.getFrontIndex(); i > vehicle.getBackIndex(); i--) {
-            eastbound[i] = &vehicle;
-        }
-    }else if (vehicle.getDirection() == Direction::west){
-        for (int i = vehicle.getFrontIndex(); i > vehicle.getBackIndex(); i--) {
-            westbound[i] = &vehicle;
-        }
-    } else {
-        for (int i = vehicle.getFrontIndex(); i > vehicle.getBackIndex(); i--) {
-            southbound[i] = &vehicle;
-        }
+template <class Lanes>
+void Simulator::printVehicle(Vehicle& vehicle, Lanes& lanes){
+    paintSpan(lanes.lane(vehicle.getDirection()), vehicle.getDirection(), vehicle.getBackIndex() + 1,
+              vehicle.getFrontIndex(), vehicle);
+}
+
+/*
+ * Marks sections first ... last of a bound as held by the vehicle this tick
+ * and counts them in the occupancy map (if any)
+ * @param Lane& lane lane of the bound
+ * @param Direction direction the bound
+ * @param int first
+ * @param int last
+ * @param Vehicle& vehicle
+ */
+template <class Lane>
+void Simulator::paintSpan(Lane& lane, Direction direction, int first, int last, Vehicle& vehicle) {
+    lane.paint(first, last, &vehicle);
+    if (occupancy) {
+        occupancy->addOccupied(direction, first, last);
+    }
+}
+
+/*
+ * Counts a tick the vehicle spent on the road without moving, for the
+ * vehicle and in the occupancy map (if any)
+ * @param Vehicle& vehicle
+ */
+void Simulator::countStoppedTick(Vehicle& vehicle) {
+    vehicle.addStoppedTick();
+    if (occupancy) {
+        occupancy->addStopped(vehicle.getDirection(), vehicle.getBackIndex() + 1, vehicle.getFrontIndex());
     }
 }
 
 
 
-/* Finds the color of light in each bound and sets the animation as such also calculates the time to be red 
- * for each light
+/* Finds the color of light in each bound for the given tick
  * @param int i value of the iteration from simulated time 
- * @param Animation& anim animator to set the lights
- * @param string& lightNSState tells the color of the NorthSouth bound
- * @param string& lightEWState tells the color of the EastWest bound
- * @param int& NSTimeToRed stores the time for NorthSouth light to be red
- * @param int& EWTimeToRed stores the time for EastWest light to be red
- */
-void Simulator::setLights(int i, Animator& anim, string& lightNSState, int& NSTimeToRed, string& lightEWState, int& EWTimeToRed) {
-    
-    int modValue = i % lightCycle;
-
-    /*
-    Format:
-        if (condition) {
-            setting the light in the animation
-            adding the string value to LightNS or LightEW's 0th position
-            adding "time left for it to be red light" to LightNS or LightEW's 1st position
-        }
-    */
-    
-    // Light for North South
-    if (modValue < greenNS) {
-        anim.setLightNorthSouth(LightColor::green);
-        lightNSState = "green"; 
-        NSTimeToRed = yellowNS + (greenNS - modValue);
-    } else if (modValue < greenNS + yellowNS) {
-        anim.setLightNorthSouth(LightColor::yellow);
-        lightNSState = "yellow";
-        NSTimeToRed = greenNS + yellowNS - modValue;
-    } else {
-        anim.setLightNorthSouth(LightColor::red);
-        lightNSState = "red";
-        NSTimeToRed = 0;
-    }
-
-    // Light for East West
-    if (modValue < greenNS + yellowNS) {
-        anim.setLightEastWest(LightColor::red);
-        lightEWState = "red";
-        EWTimeToRed = 0;
-    } else if ( modValue < greenNS + yellowNS + greenEW) {
-        anim.setLightEastWest(LightColor::green);
-        lightEWState = "green";
-        EWTimeToRed = (greenNS + yellowNS + greenEW + yellowEW) - modValue;
-    } else {
-        anim.setLightEastWest(LightColor::yellow);
-        lightEWState = "yellow";
-        EWTimeToRed = lightCycle - modValue;
+ */
+void Simulator::setLights(int i) {
+    if (pendingAdmission && i >= planSwitchTime) {
+        admission = pendingAdmission;
+        lightCycle = pendingLightCycle;
+        cycleStart = planSwitchTime;
+        pendingAdmission = nullptr;
     }
+    cyclePosition = (i - cycleStart) % lightCycle;
+
+    const LightState& lights = admission->getLights(cyclePosition);
+    lightNSState = lights.northSouth;
+    lightEWState = lights.eastWest;
 }
 
 
 /*
  * Checks if the section ahead of the vehicle is occupied or not
  * @param Vehicle& vehicle
+ * @param Lanes& lanes
  * @return bool value
  */
-bool Simulator::clearPath(Vehicle& vehicle) {
-    // The case of a vehicle moving straight
-    if (vehicle.getDirection() == Direction::north){
-        return northbound[vehicle.getFrontIndex()+1] == nullptr;
-    } else if (vehicle.getDirection() == Direction::east){
-        return eastbound[vehicle.getFrontIndex()+1] == nullptr;
-    }else if (vehicle.getDirection() == Direction::west){
-        return westbound[vehicle.getFrontIndex()+1] == nullptr;
-    } else {
-        return southbound[vehicle.getFrontIndex()+1] == nullptr;
-    }
+template <class Lanes>
+bool Simulator::clearPath(Vehicle& vehicle, Lanes& lanes) {
+    // The case of a vehicle moving straight (on a short road a vehicle can
+    // reach the last section before its back is past the intersection:
+    // nothing is ahead of it)
+    int ahead = vehicle.getFrontIndex() + 1;
+    return ahead > lanes.getRoadLen() * 2 + 1 || lanes.lane(vehicle.getDirection()).at(ahead) == nullptr;
 }
 
 /*Checks if the path is clear for vehicle to move
@@ -360,11 +895,11 @@ bool Simulator::clearPath(Vehicle& vehicle) {
  *@bool true if the vehicle can move else false
  */
 bool Simulator::clearPathTransition(Vehicle& vehicle, int& NESec, int& NWSec, int& SESec, int& SWSec) {
-    // For vehicles moving straight
+    // For vehicles moving straight (a motorcycle holds its first section for its entry tick too)
     if (vehicle.getTurn() == TurnType::straight) {
         if (vehicle.getDirection() == Direction::north) {
             if ((NESec == 0) && (NWSec == 0)){
-                NESec = vehicle.getLength()-1;
+                NESec = max(1, vehicle.getLength() - 1);
                 NWSec = vehicle.getLength();
                 return true;
             } else {
@@ -372,7 +907,7 @@ bool Simulator::clearPathTransition(Vehicle& vehicle, int& NESec, int& NWSec, in
             }
         } else if (vehicle.getDirection() == Direction::east) {
             if ((SESec == 0) && (NESec == 0)){
-                SESec = vehicle.getLength()-1;
+                SESec = max(1, vehicle.getLength() - 1);
                 NESec = vehicle.getLength();
                 return true;
             } else {
@@ -380,7 +915,7 @@ bool Simulator::clearPathTransition(Vehicle& vehicle, int& NESec, int& NWSec, in
             }
         }else if (vehicle.getDirection() == Direction::west) {
             if ((NWSec == 0) && (SWSec == 0)) {
-                NWSec = vehicle.getLength()-1;
+                NWSec = max(1, vehicle.getLength() - 1);
                 SWSec = vehicle.getLength();
                 return true;
             } else {
@@ -388,7 +923,7 @@ bool Simulator::clearPathTransition(Vehicle& vehicle, int& NESec, int& NWSec, in
             }
         } else {
             if ((SWSec == 0) && (SESec == 0)) {
-                SWSec = vehicle.getLength()-1;
+                SWSec = max(1, vehicle.getLength() - 1);
                 SESec = vehicle.getLength();
                 return true;
             } else {
@@ -468,237 +1003,165 @@ bool Simulator::clearPathTransition(Vehicle& vehicle, int& NESec, int& NWSec, in
 }
 
 /*
- * @param Vehcile& vehicle the light of the vehicle's lane will be checked
- * @param string& lightNSState tells the color of the North-South lane
- * @param string& lightEWState tells the color of the East-West lane
- * @return bool value: true if the vehicle can move, false if the vehicle cannot move (light is red)
- */
-bool Simulator::checkLight(Vehicle& vehicle, string& lightNSState, string& LightEWState) {
-    if ((vehicle.getVehicleOriginalDirection() == Direction::north) 
-            || (vehicle.getVehicleOriginalDirection() == Direction::south)) {
-        return (lightNSState != "red");
-    } else {
-        return (LightEWState != "red");
-    }
-}
-
-/*
- * Checks if the vehicle has enough time to make full transition before red light
- * @param Vehicle& vehicle 
- * @param int LightNS NS light status
- * @param int LightEW EW light status
- * @return bool value true: if the vehicle has enough time to make the transition
- * false: if the vehicle doesn't have enought time to make the transition
-*/
-bool Simulator::checkMove(Vehicle& vehicle, int NSTimeToRed, int EWTimeToRed) {
-    int checkLength; 
-    if (vehicle.getTurn() == TurnType::right) {
-        checkLength = vehicle.getLength() - 1;
-    } else {
-        checkLength = vehicle.getLength(); 
-    }
-    // Check enough time before red-light for full transition
-    if ((vehicle.getVehicleOriginalDirection() == Direction::north) 
-            || (vehicle.getVehicleOriginalDirection() == Direction::south)) {
-        return (NSTimeToRed > checkLength);
-    } else {
-        return (EWTimeToRed > checkLength);
-    }
-}
-
-/*
- * Moves the vehicles that are turning right through the intersection in phases
- * depending on the type (length) of the vehicle
+ * Moves a turning vehicle one phase through the intersection. Each phase puts
+ * one more section of the new bound under the vehicle (from roadLen + 2 for a
+ * right turn, roadLen + 1 for a left turn) and one less of its own bound; a
+ * vehicle of length L is done after max(1, L - 1) phases, so every class
+ * takes the same path whatever its length
  * @param Vehicle& vehicle
- * @param vector<vector<VehicleBase*>*>& allBounds used to calculate the next bound for the
- * vehicle (the one it's transitioning into)
+ * @param Lanes& lanes holds the vehicle's own bound and the one it's transitioning into
  */
-void Simulator::moveTransition(Vehicle& vehicle, vector<vector<VehicleBase*>*>& allBounds){
-    
-    int orrIndex;
-    int nextIndex;
-    int vehicleLength;
+template <class Lanes>
+void Simulator::moveTransition(Vehicle& vehicle, Lanes& lanes) {
 
-    vector<Direction> directions = {Direction::north, Direction::west, Direction::south, Direction::east};
+    static const Direction directions[] = {Direction::north, Direction::west, Direction::south, Direction::east};
 
     // Getting indexes of current direction, then finding the next direction from it.
-    orrIndex = distance(directions.begin(), find(directions.begin(), directions.end(), vehicle.getVehicleOriginalDirection()));
-    nextIndex = (orrIndex + 3) % 4;
-    vehicleLength = vehicle.getLength();
-
-    // First Phase of Transition for all vehicles (only transition phase for car)
-    if (vehicle.getFrontIndex() == roadLen) {
-        // vehicle in the transitioning bound
-        (*allBounds[nextIndex])[roadLen + 2] = &vehicle;
-
-        // vehicle in its own original bound
-        for (int i = roadLen; i > (roadLen - vehicleLength + 1); i--) {
-            (*allBounds[orrIndex])[i] = &vehicle;
-        }
-
-        // Changing vehicle's Start Index as it changed after making the turn
-        vehicle.setFrontIndex(roadLen + 2);
-
-        // If vehicle is car, inTransition will be off from here
-        if (vehicle.getVehicleType() == VehicleType::car){
-            // Transition phase is over
-            vehicle.setTransition(false);
-            
-            // Recompute the vehicle index as they have moved two steps forward
-            vehicle.setBackIndex(roadLen);
-            
-            // new currDirection will be set
-            vehicle.setDirection(directions[nextIndex]);
-        }
+    bool right = vehicle.getTurn() == TurnType::right;
+    int orrIndex = distance(begin(directions), find(begin(directions), end(directions), vehicle.getVehicleOriginalDirection()));
+    int nextIndex = (orrIndex + (right ? 3 : 1)) % 4;
+    int vehicleLength = vehicle.getLength();
 
-    // Second Phase of Transition for all vehicles 
-    } else if (vehicle.getFrontIndex() == roadLen + 2) { // The next step (Conditional on type of car)
-        // Vehicle in the transitioning bound
-        (*allBounds[nextIndex])[roadLen + 2] = &vehicle;
-        (*allBounds[nextIndex])[roadLen + 3] = &vehicle;
+    const int roadLen = lanes.getRoadLen();
+    typename Lanes::Lane& ownLane = lanes.lane(directions[orrIndex]);
+    typename Lanes::Lane& nextLane = lanes.lane(directions[nextIndex]);
 
-        // Vehicle in its own original bound
-        for (int i = roadLen; i > (roadLen - vehicleLength + 2); i--) {
-            (*allBounds[orrIndex])[i] = &vehicle;
-        }
+    int phase = transitionPhase(vehicle) + 1;
+    int firstTurned = right ? roadLen + 2 : roadLen + 1;
+    int newFront = firstTurned + phase - 1;
 
-        // Changing vehicle's Start Index
-        vehicle.setFrontIndex(roadLen + 3);
-        
-        // If vehicle is SUV, inTransition will be off from here
-        if (vehicle.getVehicleType() == VehicleType::suv) {
-            
-            //Transition phase is over
-            vehicle.setTransition(false);
-
-            // Recompute the vehicle index as they have moved two steps forward 
-            // Realize the vehicle index has not been modified during the transition phase
-            vehicle.setBackIndex(roadLen);
-
-            // Change the value of the original direction of the vehicle for suv
-            vehicle.setDirection(directions[nextIndex]);
-        }
+    // Vehicle in the transitioning bound
+    paintSpan(nextLane, directions[nextIndex], firstTurned, newFront, vehicle);
 
-    // Third Phase of Transition (only possible for Trucks)   
-    } else if (vehicle.getFrontIndex() == roadLen + 3){
-        // Vehicle in the transitioning bound
-        (*allBounds[nextIndex])[roadLen + 2] = &vehicle;
-        (*allBounds[nextIndex])[roadLen + 3] = &vehicle;
-        (*allBounds[nextIndex])[roadLen + 4] = &vehicle;    
-
-        // Vehicle in its own original bound
-        for (int i = roadLen; i > (roadLen - vehicleLength + 3); i--) {
-            (*allBounds[orrIndex])[i] = &vehicle;
-        }
+    // Vehicle in its own original bound (nothing left of a motorcycle)
+    if (phase < vehicleLength) {
+        paintSpan(ownLane, directions[orrIndex], roadLen - vehicleLength + 1 + phase, roadLen, vehicle);
+    }
 
-        // No condition required here as we know it's a truck
-        // Changing vehicle's Start Index
-        vehicle.setFrontIndex(roadLen + 4);
+    vehicle.setFrontIndex(newFront);
 
-        // Recalculating vehicle's front and back index (not updated at all during transition phase, so +4)
-        vehicle.setBackIndex(roadLen);
+    if (phase >= max(1, vehicleLength - 1)) {
+        // Transition phase is over: the back index wasn't updated during it
         vehicle.setTransition(false);
+        vehicle.setBackIndex(newFront - vehicleLength);
+        // a motorcycle turning right is already clear of the intersection
+        if (vehicle.getBackIndex() == roadLen + 1) {
+            heldTicks = 0;
+        }
 
-        // Change the value of the original direction of the vehicle for truck
+        // New currDirection will be set
         vehicle.setDirection(directions[nextIndex]);
     }
 }
 
 /*
- * Moves the vehicles that are turning left through the intersection in phases
- * depending on the type (length) of the vehicle (similar to moveTransition())
- * @param Vehicle& vehicle
- * @param vector<vector<VehicleBase*>*>& allBounds used to calculate the next bound for the
- * vehicle (the one it's transitioning into)
+ * Moves the vehicles away from the intersection with a Nagel-Schreckenberg
+ * cellular-automaton model: a vehicle accelerates by one section per tick up to
+ * max_speed, slows down to the gap left by the vehicle ahead (positions at the
+ * start of the tick) and brakes by one section with slowdown_probability.
+ * Vehicles at the stop line or in the intersection are left to the main loop,
+ * so checkLight/clearPathTransition and the transitions are unchanged.
  */
-void Simulator::moveTransitionLeft(Vehicle& vehicle, vector<vector<VehicleBase*>*>& allBounds) {
-    int orrIndex;
-    int nextIndex;
-    int vehicleLength;
+void Simulator::moveCellular() {
+    AllocationSite site("Simulator::moveCellular");
+    int maxIndex = roadLen * 2 + 1;
 
-    vector<Direction> directions = {Direction::north, Direction::west, Direction::south, Direction::east};
+    cellularMoved.assign(vehicles.size(), 0);
+    for (CellularLane& lane : cellularLanes) {
+        lane.index.clear();
+        lane.front.clear();
+        lane.back.clear();
+        lane.length.clear();
+        lane.speed.clear();
+        lane.brake.clear();
+        lane.barrier = roadLen;
+    }
 
-    // Getting indexes of current direction, then finding the next direction from it.
-    orrIndex = distance(directions.begin(), find(directions.begin(), directions.end(), vehicle.getVehicleOriginalDirection()));
-    nextIndex = (orrIndex + 1) % 4;
-    vehicleLength = vehicle.getLength();
-
-    // First Phase of Transition for all vehicles (only transition phase for car)
-    if (vehicle.getFrontIndex() == roadLen) {
-        // Vehicle in the transitioning bound
-        (*allBounds[nextIndex])[roadLen + 1] = &vehicle;
-
-        // Vehicle in its own original bound
-        for (int i = roadLen; i > (roadLen - vehicleLength + 1); i--) {
-            (*allBounds[orrIndex])[i] = &vehicle;
+    for (int k = 0; k < static_cast<int>(vehicles.size()); k++) {
+        Vehicle& vehicle = vehicles[k];
+
+        // Past the intersection the vehicles ahead left earlier and are at least as fast
+        if (vehicle.getBackIndex() > roadLen + 2) {
+            int speed = min(vehicle.getSpeed() + 1, maxSpeed);
+            vehicle.setSpeed(speed);
+            vehicle.setBackIndex(vehicle.getBackIndex() + speed);
+            vehicle.setFrontIndex(min(maxIndex, vehicle.getBackIndex() + vehicle.getLength()));
+            cellularMoved[k] = 1;
+            continue;
         }
 
-        // Changing vehicle's Start Index as it changed after making the turn
-        vehicle.setFrontIndex(roadLen + 1);
-
-    
-        //if vehicle is car, inTransition will be off from here
-        if (vehicle.getVehicleType() == VehicleType::car) {
-            // Transition phase is over
-            vehicle.setTransition(false);
-            
-            // Recompute the vehicle index as they have moved two steps forward
-            vehicle.setBackIndex(roadLen - 1);
-            
-            // New currDirection will be set
-            vehicle.setDirection(directions[nextIndex]);
+        CellularLane& lane = cellularLanes[static_cast<int>(vehicle.getDirection())];
+
+        if (!vehicle.getInTransition() && vehicle.getFrontIndex() + 1 < roadLen) {
+            // Approaching the stop line (vehicles keep their order in vehicles)
+            lane.index.push_back(k);
+            lane.front.push_back(vehicle.getFrontIndex());
+            lane.back.push_back(vehicle.getBackIndex());
+            lane.length.push_back(vehicle.getLength());
+            lane.speed.push_back(vehicle.getSpeed());
+            lane.brake.push_back(slowdownProbability > 0 &&
+                                 rand_double(slowdownGenerator) < slowdownProbability);
+        } else {
+            // At the stop line or in the intersection
+            lane.barrier = min(lane.barrier, vehicle.getBackIndex() + 1 + transitionPhase(vehicle));
         }
+    }
 
+    for (CellularLane& lane : cellularLanes) {
+        moveLaneCellular(lane);
+    }
+}
 
-        // Second Phase of Transition for all vehicles 
-    } else if (vehicle.getFrontIndex() == roadLen + 1) {
-        // Vehicle in the transitioning bound
-        (*allBounds[nextIndex])[roadLen + 2] = &vehicle;
-        (*allBounds[nextIndex])[roadLen + 1] = &vehicle;
-
-        // Vehicle in its own original bound
-        for (int i = roadLen; i > (roadLen - vehicleLength + 2); i--) {
-            (*allBounds[orrIndex])[i] = &vehicle;
-        }
-
-        // Changing vehicle's Start Index
-        vehicle.setFrontIndex(roadLen + 2);
-        
-        // If vehicle is SUV, inTransition will be off from here
-        if (vehicle.getVehicleType() == VehicleType::suv) {
-            // Transition phase is over
-            vehicle.setTransition(false);
+/*
+ * Speed and position update of the vehicles approaching the stop line of one bound
+ * @param CellularLane& lane vehicles of the bound, first one closest to the intersection
+ */
+void Simulator::moveLaneCellular(CellularLane& lane) {
+    int count = lane.index.size();
+    if (count == 0) {
+        return;
+    }
 
-            // Recompute the vehicle index as they have moved two steps forward 
-            // Realize the vehicle index has not been modified during the transition phase
-            vehicle.setBackIndex(roadLen - 1);
+    // Gap to the leader: up to the section behind it, never past the stop line
+    lane.limit.resize(count);
+    lane.limit[0] = min(lane.barrier - 1, roadLen - 1);
+    for (int j = 1; j < count; j++) {
+        lane.limit[j] = min(lane.back[j - 1], roadLen - 1);
+    }
 
-            //Change the value of the original direction of the vehicle for suv
-            vehicle.setDirection(directions[nextIndex]);
-        }
+    // Accelerate, keep the gap, brake randomly, move
+    for (int j = 0; j < count; j++) {
+        int speed = min(lane.speed[j] + 1, maxSpeed);
+        speed = min(speed, lane.limit[j] - lane.front[j]);
+        speed = max(speed - lane.brake[j], 0);
+        lane.speed[j] = speed;
+        lane.front[j] += speed;
+        lane.back[j] = max(-1, lane.front[j] - lane.length[j]);
+    }
 
-        // Third Phase of Transition (only possible for Trucks)   
-    } else if (vehicle.getFrontIndex() == roadLen + 2){ //can be made an else statement
-        // Vehicle in the transitioning bound
-        (*allBounds[nextIndex])[roadLen + 1] = &vehicle;
-        (*allBounds[nextIndex])[roadLen + 2] = &vehicle;
-        (*allBounds[nextIndex])[roadLen + 3] = &vehicle;
-        
-
-        // Vehicle in its own original bound
-        for (int i = roadLen; i > (roadLen - vehicleLength + 3); i--) {
-            (*allBounds[orrIndex])[i] = &vehicle;
-        }
+    for (int j = 0; j < count; j++) {
+        Vehicle& vehicle = vehicles[lane.index[j]];
+        vehicle.setFrontIndex(lane.front[j]);
+        vehicle.setBackIndex(lane.back[j]);
+        vehicle.setSpeed(lane.speed[j]);
+        cellularMoved[lane.index[j]] = 1;
+    }
+}
 
-        // No condition required here as we know it's a truck
-        // Changing vehicle's Start Index
-        vehicle.setFrontIndex(roadLen + 3);
-        vehicle.setBackIndex(roadLen - 1);
-        vehicle.setTransition(false);
-        
-        // Change the value of the original direction of the vehicle for truck
-        vehicle.setDirection(directions[nextIndex]);
+/*
+ * Number of transition phases a turning vehicle has completed. While turning it
+ * still covers its original bound from backIndex + 1 + phase up to roadLen
+ * @param Vehicle& vehicle
+ * @return int completed phases (0 if the vehicle is not turning)
+ */
+int Simulator::transitionPhase(Vehicle& vehicle) {
+    if (!vehicle.getInTransition() || vehicle.getFrontIndex() == roadLen) {
+        return 0;
+    }
+    if (vehicle.getTurn() == TurnType::right) {
+        return vehicle.getFrontIndex() - roadLen - 1;
     }
+    return vehicle.getFrontIndex() - roadLen;
 }
 
 #endif
\ No newline at end of file
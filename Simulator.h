@@ -4,14 +4,52 @@
 #include <iostream>
 #include <vector>
 #include <tuple>
+#include <random>
+#include <string>
+#include <memory>
+#include <array>
+#include <variant>
 #include "Animator.h"
+#include "SimConfig.h"
+#include "AdmissionTable.h"
+#include "ArrivalLog.h"
+#include "DemandProfile.h"
+#include "EntryQueue.h"
+#include "LifetimeWriter.h"
+#include "OccupancyMap.h"
+#include "RoadLanes.h"
+#include "RunStatistics.h"
 #include "Vehicle.h"
 #include "VehicleBase.h"
 
 using namespace std;
 
+// Bumped whenever a change alters trajectories or statistics (results cached
+// by an older engine are then ignored)
+const int ENGINE_VERSION = 4;
+
+// Upper bound on the vehicles vector capacity reserved up front
+const int MAX_RESERVED_VEHICLES = 1 << 16;
+
+// Bytes of arrival log read before their pages are given back
+const size_t ARRIVAL_LOG_RELEASE_BYTES = 64 << 20;
+
+// Vehicles of one bound moved by the cellular-automaton model, stored field by
+// field so that the speed update is a single pass over plain arrays
+struct CellularLane {
+    vector<int> index;      // position in Simulator::vehicles
+    vector<int> front;
+    vector<int> back;
+    vector<int> length;
+    vector<int> speed;
+    vector<int> brake;      // 1 if the vehicle randomly slows down this tick
+    vector<int> limit;      // last section the vehicle may reach this tick
+    int barrier;            // first section held by a vehicle at the stop line or in the intersection
+};
+
 class Simulator{
     private:
+        SimConfig config;
         int seed;
         int simTime;
         int roadLen;
@@ -20,40 +58,157 @@ class Simulator{
         int greenEW;
         int yellowEW;
         int lightCycle;
-        double probNB;
-        double probSB;
-        double probEB;
-        double probWB;
-        double proportionCars;
-        double proportionSUVs;
-        double proportionCarRight;
-        double proportionCarLeft;
-        double proportionSUVRight;
-        double proportionSUVLeft;
-        double proportionTruckRight;
-        double proportionTruckLeft;
-
-
-        vector<VehicleBase*> westbound;
-        vector<VehicleBase*> eastbound;
-        vector<VehicleBase*> southbound;
-        vector<VehicleBase*> northbound;
+        bool poissonArrivals;
+        bool pairedRandomStreams;
+        int stallTicks;
+        bool cellular;
+        int maxSpeed;
+        double slowdownProbability;
+        int freeFlowBase;          // free-flow travel time less the vehicle length (see freeFlowTicks)
+
+
+        // Sections of the four bounds: fixed-size arrays for the standard road
+        // lengths, per-vehicle spans for very long roads, vectors otherwise
+        LaneEngine laneEngine;
+        variant<DynamicLanes, FixedLanes<10>, FixedLanes<20>, FixedLanes<50>, QueueLanes> roadLanes;
 
         vector<Vehicle> vehicles;
 
+        // State carried from one tick to the next
+        mt19937 randomNumberGenerator; // Mersenne twister
+        uniform_real_distribution<double> rand_double;
+        poisson_distribution<int> rand_poisson;
+
+        // With paired_random_streams: one stream per bound for the arrivals (one
+        // draw per tick) and one for the type and turn of its vehicles (two draws
+        // per vehicle), so runs of different configurations with the same seed
+        // see the same vehicles at the same ticks
+        mt19937 arrivalGenerators[4];
+        mt19937 vehicleGenerators[4];
+        int currentTime;
+        int nextVehicleID;
+        int cyclePosition;
+        LightColor lightNSState;
+        LightColor lightEWState;
+
+        // Stop-line decisions for every position of the light cycle
+        shared_ptr<const AdmissionTable> admission;
+
+        // Light durations given to retime(), adopted at the end of the running cycle
+        int cycleStart;                                     // tick the running durations count their cycles from
+        int planSwitchTime;                                 // tick the pending durations take over
+        int pendingLightCycle;
+        shared_ptr<const AdmissionTable> pendingAdmission;  // nullptr: nothing pending
+
+        // Arrival rates and type/turn thresholds, per block of ticks
+        shared_ptr<const DemandProfile> demandProfile;  // nullptr: constant demand of the configuration
+        shared_ptr<const DemandTable> demand;
+        const DemandLevel* demandLevel;                 // demand of the current tick
+
+        // Recorded arrivals replayed instead of the random spawns (if not nullptr)
+        shared_ptr<const ArrivalLog> arrivalLog;
+        size_t arrivalCursor;       // position of the record after nextArrival
+        size_t releasedCursor;      // pages before this position were given back
+        LoggedArrival nextArrival;
+        bool arrivalPending;        // nextArrival holds a record not enqueued yet
+
+        // Receives a record of every vehicle leaving the map (if not nullptr)
+        shared_ptr<LifetimeWriter> lifetimeWriter;
+
+        // Counts the ticks every section is held (if not nullptr)
+        shared_ptr<OccupancyMap> occupancy;
+
+        // Vehicles waiting off the map, per bound (indexed by Direction)
+        EntryQueue entryQueues[4];
+        int entryWaiting[4];   // index in vehicles of the released vehicle not yet on section 0
+        long droppedSpawns;
+
+        RunStatistics statistics;
+
+        // Stall detection: ticks a vehicle was held at the stop line since one
+        // last entered or cleared the intersection
+        int heldTicks;
+        bool stalled;
+
+        // Cellular-automaton model (only used when cellular is true)
+        mt19937 slowdownGenerator;
+        CellularLane cellularLanes[4];
+        vector<uint8_t> cellularMoved;
+
+        // Section checks
+        int NESec;
+        int NWSec;
+        int SESec;
+        int SWSec;
+
+        void applyConfig();
+        void initLanes();
+        void dropExitedVehicles();
+        void spawnPairedVehicles(Direction direction, double inputLaneProb);
+        void replayArrivals();
+        static int poissonQuantile(double probability, double rate);
+        int freeRunTicks(int from, int to, int speed) const;
+        int freeFlowTicks(const Vehicle& vehicle) const;
+        static string changedParameter(const SimConfig& current, const SimConfig& next,
+                                       bool (*allowed)(const string&));
+
+        // Simulation kernels, instantiated for every lane storage
+        template <class Lanes> void tick(Lanes& lanes);
+        template <class Lanes> void moveStraight(Vehicle& vehicle, Lanes& lanes);
+        template <class Lanes> void printVehicle(Vehicle& vehicle, Lanes& lanes);
+        template <class Lane> void paintSpan(Lane& lane, Direction direction, int first, int last, Vehicle& vehicle);
+        void countStoppedTick(Vehicle& vehicle);
+        template <class Lanes> bool clearPath(Vehicle& vehicle, Lanes& lanes);
+        template <class Lanes> void moveTransition(Vehicle& vehicle, Lanes& lanes);
+
     public:
         Simulator(string file, int seed);
+        Simulator(const SimConfig& config, int seed, shared_ptr<const AdmissionTable> admission = nullptr);
         void runSimulation();
-        void setLights(int i, Animator& anim, string& lightNSState, int& NSTimeToRed, string& lightEWState, int& EWTimeToRed);
-        void moveStraight(Vehicle& vehicle);
-        void printVehicle(Vehicle& vehicle);
-        bool clearPath(Vehicle& vehicle);
+        int step(int ticks = 1);
+        void reset();
+        void reset(int seed);
+        void setLights(int i);
+        void setConfig(const SimConfig& config, shared_ptr<const AdmissionTable> admission = nullptr);
+        void retime(const SimConfig& config, shared_ptr<const AdmissionTable> admission = nullptr);
+        void redemand(const SimConfig& config);
+        static bool isRetimable(const string& name);
+        static bool isDemandParameter(const string& name);
+        void setDemandProfile(shared_ptr<const DemandProfile> profile);
+        void setArrivalLog(shared_ptr<const ArrivalLog> log);
+        inline void setLifetimeWriter(shared_ptr<LifetimeWriter> writer) { lifetimeWriter = writer; }
+        inline shared_ptr<LifetimeWriter> getLifetimeWriter() const { return lifetimeWriter; }
+        void setOccupancyMap(shared_ptr<OccupancyMap> map);
+        inline shared_ptr<OccupancyMap> getOccupancyMap() const { return occupancy; }
+        void setLaneEngine(LaneEngine engine);
+        string getLaneEngineName() const;
         bool clearPathTransition(Vehicle& vehicle, int& NESec, int& NWSec, int& SESec, int& SWSec);
-        void moveTransition(Vehicle& vehicle, vector<vector<VehicleBase*>*>& allBounds);
-        bool checkLight(Vehicle& vehicle, string& lightNSState, string& LightEWState);
-        bool checkMove(Vehicle& vehicle, int NSTimeToRed, int EWTimeToRed);
-        void addVehicle(vector<VehicleBase*>& bound, Direction direction, double inputLaneProb, double spawnProb, double typeProb, double turnProb);
-        void moveTransitionLeft(Vehicle& vehicle, vector<vector<VehicleBase*>*>& allBounds);
+        void spawnVehicles(Direction direction, double inputLaneProb);
+        void addVehicle(Direction direction, double typeProb, double turnProb);
+        void enqueueVehicle(Direction direction, VehicleType type, TurnType turn);
+        void releaseVehicle(Direction direction);
+        void moveCellular();
+        void moveLaneCellular(CellularLane& lane);
+        int transitionPhase(Vehicle& vehicle);
+
+        // Read-only views of the current state (no copies)
+        LaneView getLane(Direction direction) const;
+        inline const vector<Vehicle>& getVehicles() const { return vehicles; }
+        inline LightColor getLightNorthSouth() const { return lightNSState; }
+        inline LightColor getLightEastWest() const { return lightEWState; }
+        inline int getTime() const { return currentTime; }
+        inline bool isFinished() const { return currentTime >= simTime || stalled; }
+        inline bool isStalled() const { return stalled; }
+        string describeStall() const;
+        inline int getSeed() const { return seed; }
+        inline int getQueueLength(Direction direction) const { return entryQueues[static_cast<int>(direction)].size(); }
+        inline const EntryQueue& getEntryQueue(Direction direction) const { return entryQueues[static_cast<int>(direction)]; }
+        inline array<int, 4> getSectionReservations() const { return {NESec, NWSec, SESec, SWSec}; }
+        inline long getDroppedSpawns() const { return droppedSpawns; }
+        inline const RunStatistics& getStatistics() const { return statistics; }
+        inline const SimConfig& getConfig() const { return config; }
+        inline bool hasExternalDemand() const { return demandProfile || arrivalLog; }
+        inline shared_ptr<const AdmissionTable> getAdmissionTable() const { return admission; }
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,56 @@
+#ifndef __SPSC_RING_H__
+#define __SPSC_RING_H__
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+/*
+ * Lock-free ring of preallocated slots shared by exactly one producer thread
+ * and one consumer thread. The producer fills the slot returned by
+ * beginPush() in place and publishes it with commitPush(); the consumer reads
+ * front() and releases it with pop(). Slots are reused, so objects that keep
+ * their capacity (strings, vectors) stop allocating once warmed up.
+ */
+template <class T>
+class SpscRing {
+    private:
+        std::vector<T> slots;
+        alignas(64) std::atomic<size_t> head;   // next slot to read (consumer)
+        alignas(64) std::atomic<size_t> tail;   // next slot to write (producer)
+
+    public:
+        SpscRing(size_t capacity) : slots(capacity), head(0), tail(0) {}
+
+        // Producer: free slot to fill, or nullptr if the ring is full
+        T* beginPush() {
+            size_t t = tail.load(std::memory_order_relaxed);
+            if (t - head.load(std::memory_order_acquire) == slots.size()) {
+                return nullptr;
+            }
+            return &slots[t % slots.size()];
+        }
+
+        // Producer: publishes the slot returned by beginPush()
+        void commitPush() {
+            tail.store(tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        }
+
+        // Consumer: oldest published slot, or nullptr if the ring is empty
+        T* front() {
+            size_t h = head.load(std::memory_order_relaxed);
+            if (h == tail.load(std::memory_order_acquire)) {
+                return nullptr;
+            }
+            return &slots[h % slots.size()];
+        }
+
+        // Consumer: gives the slot returned by front() back to the producer
+        void pop() {
+            head.store(head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        }
+
+        size_t capacity() const { return slots.size(); }
+};
+
+#endif
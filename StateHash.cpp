@@ -0,0 +1,105 @@
+#ifndef __STATE_HASH_CPP__
+#define __STATE_HASH_CPP__
+
+#include "StateHash.h"
+
+using namespace std;
+
+StateHash::StateHash() : rolling(0) {}
+
+/*
+ * Starts a new hash stream (e.g. after Simulator::reset)
+ */
+void StateHash::reset() {
+    rolling = 0;
+}
+
+/*
+ * Hashes the state reached after the last tick and chains it to the stream
+ * @param const Simulator& sim
+ * @param TickDigest& digest filled with the tick hash and the per-vehicle hashes
+ */
+void StateHash::update(const Simulator& sim, TickDigest& digest) {
+    digest.globalHash = globalHash(sim);
+    digest.vehicles.clear();
+
+    uint64_t hash = mix(rolling, digest.globalHash);
+    for (const Vehicle& vehicle : sim.getVehicles()) {
+        if (!onMap(sim, vehicle)) {
+            continue;
+        }
+        uint32_t vehicleState = vehicleHash(vehicle);
+        digest.vehicles.push_back(VehicleDigest{vehicle.getVehicleID(), vehicleState});
+        hash = mix(hash, (static_cast<uint64_t>(vehicle.getVehicleID()) << 32) | vehicleState);
+    }
+
+    rolling = hash;
+    digest.hash = hash;
+}
+
+/*
+ * Combines a value into a hash (multiply-xorshift mixing)
+ * @param uint64_t hash
+ * @param uint64_t value
+ * @return uint64_t
+ */
+uint64_t StateHash::mix(uint64_t hash, uint64_t value) {
+    hash ^= value + 0x9e3779b97f4a7c15ULL + (hash << 6) + (hash >> 2);
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+/*
+ * @param const Vehicle& vehicle
+ * @return uint32_t hash of the vehicle's position, direction, type, turn and transition state
+ */
+uint32_t StateHash::vehicleHash(const Vehicle& vehicle) {
+    uint64_t hash = 0;
+    hash = mix(hash, static_cast<uint32_t>(vehicle.getFrontIndex()));
+    hash = mix(hash, static_cast<uint32_t>(vehicle.getBackIndex()));
+    hash = mix(hash, static_cast<uint64_t>(vehicle.getSpeed()) << 8 | vehicle.getInTransition());
+    hash = mix(hash, static_cast<uint64_t>(vehicle.getVehicleType()) << 24 |
+                     static_cast<uint64_t>(vehicle.getTurn()) << 16 |
+                     static_cast<uint64_t>(vehicle.getVehicleOriginalDirection()) << 8 |
+                     static_cast<uint64_t>(vehicle.getDirection()));
+    return static_cast<uint32_t>(hash ^ (hash >> 32));
+}
+
+/*
+ * @param const Simulator& sim
+ * @return uint64_t hash of the time, the lights, the section reservations and the entry queues
+ */
+uint64_t StateHash::globalHash(const Simulator& sim) {
+    uint64_t hash = 0;
+    hash = mix(hash, sim.getTime());
+    hash = mix(hash, static_cast<uint64_t>(sim.getLightNorthSouth()) << 8 |
+                     static_cast<uint64_t>(sim.getLightEastWest()));
+    for (int reservation : sim.getSectionReservations()) {
+        hash = mix(hash, static_cast<uint32_t>(reservation));
+    }
+
+    Direction directions[] = {Direction::north, Direction::south, Direction::east, Direction::west};
+    for (Direction direction : directions) {
+        const EntryQueue& queue = sim.getEntryQueue(direction);
+        hash = mix(hash, queue.size());
+        for (int i = 0; i < queue.size(); i++) {
+            const PendingVehicle& pending = queue.at(i);
+            hash = mix(hash, static_cast<uint64_t>(pending.id) << 32 |
+                             static_cast<uint64_t>(pending.type) << 8 |
+                             static_cast<uint64_t>(pending.turn));
+        }
+    }
+    return hash;
+}
+
+/*
+ * @param const Simulator& sim
+ * @param const Vehicle& vehicle
+ * @return bool false once the whole vehicle is past the last section
+ */
+bool StateHash::onMap(const Simulator& sim, const Vehicle& vehicle) {
+    return vehicle.getBackIndex() < sim.getConfig().roadLen * 2 + 1;
+}
+
+#endif
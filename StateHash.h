@@ -0,0 +1,46 @@
+#ifndef __STATE_HASH_H__
+#define __STATE_HASH_H__
+
+#include <cstdint>
+#include <vector>
+#include "Simulator.h"
+#include "Vehicle.h"
+
+using namespace std;
+
+// Hash of one vehicle still on the map
+struct VehicleDigest {
+    int32_t id;
+    uint32_t hash;
+};
+
+// State of the simulator after one tick
+struct TickDigest {
+    uint64_t hash;                      // rolling: includes every earlier tick
+    uint64_t globalHash;                // time, lights, section reservations, entry queues
+    vector<VehicleDigest> vehicles;     // in the order of Simulator::vehicles
+};
+
+/*
+ * Hashes the full simulator state after every tick so that two runs (or two
+ * engine variants) can be checked for identical trajectories. The tick hash
+ * chains the previous one, so equal hashes at tick t mean equal states at
+ * every tick up to t. Vehicles that have left the map are not part of the state.
+ */
+class StateHash {
+    private:
+        uint64_t rolling;
+
+    public:
+        StateHash();
+
+        void reset();
+        void update(const Simulator& sim, TickDigest& digest);
+
+        static uint64_t mix(uint64_t hash, uint64_t value);
+        static uint32_t vehicleHash(const Vehicle& vehicle);
+        static uint64_t globalHash(const Simulator& sim);
+        static bool onMap(const Simulator& sim, const Vehicle& vehicle);
+};
+
+#endif
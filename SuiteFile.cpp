@@ -0,0 +1,55 @@
+#ifndef __SUITE_FILE_CPP__
+#define __SUITE_FILE_CPP__
+
+#include "SuiteFile.h"
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+using namespace std;
+
+/*
+ * Reads "config_file seed ticks" lines ('#' starts a comment); config paths are
+ * relative to the suite file
+ * @param const string& suiteFile
+ * @return vector<SuiteEntry>
+ * @throws runtime_error if the file can't be read or a line is invalid
+ */
+vector<SuiteEntry> SuiteFile::read(const string& suiteFile) {
+    ifstream infile {suiteFile};
+    if (!infile) {
+        throw runtime_error("Unable to open suite file: " + suiteFile);
+    }
+
+    filesystem::path base = filesystem::path(suiteFile).parent_path();
+    vector<SuiteEntry> suite;
+    string line;
+    while (getline(infile, line)) {
+        line = line.substr(0, line.find('#'));
+        istringstream fields {line};
+        SuiteEntry entry;
+        if (!(fields >> entry.configFile)) {
+            continue;
+        }
+        if (!(fields >> entry.seed >> entry.ticks)) {
+            throw runtime_error("Invalid suite line: " + line);
+        }
+        entry.configFile = (base / entry.configFile).string();
+        suite.push_back(entry);
+    }
+    return suite;
+}
+
+/*
+ * @param const SuiteEntry& entry
+ * @return Simulator for the entry's configuration and seed, running for the entry's ticks
+ */
+Simulator SuiteFile::makeSimulator(const SuiteEntry& entry) {
+    map<string, double> parameters = SimConfig::fromFile(entry.configFile).getParameters();
+    parameters["maximum_simulated_time"] = entry.ticks;
+    return Simulator(SimConfig::fromParameters(parameters), entry.seed);
+}
+
+#endif
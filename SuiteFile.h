@@ -0,0 +1,26 @@
+#ifndef __SUITE_FILE_H__
+#define __SUITE_FILE_H__
+
+#include <string>
+#include <vector>
+#include "Simulator.h"
+
+using namespace std;
+
+// One line of a suite file: run config_file with seed for ticks ticks
+struct SuiteEntry {
+    string configFile;
+    int seed;
+    int ticks;
+};
+
+/*
+ * Lists of runs shared by the checking tools (CheckDeterminism, CheckAllocations)
+ */
+class SuiteFile {
+    public:
+        static vector<SuiteEntry> read(const string& suiteFile);
+        static Simulator makeSimulator(const SuiteEntry& entry);
+};
+
+#endif
@@ -0,0 +1,152 @@
+#ifndef __TICK_PACER_CPP__
+#define __TICK_PACER_CPP__
+
+#include "TickPacer.h"
+
+#include <cstdio>
+#include <iostream>
+#include <stdexcept>
+#include <thread>
+
+using namespace std;
+
+DurationHistogram::DurationHistogram() : counts(), total(0), sum(0), longest(0) {}
+
+/*
+ * @param long nanoseconds
+ */
+void DurationHistogram::add(long nanoseconds) {
+    nanoseconds = nanoseconds < 0 ? 0 : nanoseconds;
+    int bucket = 0;
+    for (long microseconds = nanoseconds / 1000; microseconds > 0 && bucket < BUCKETS - 1; microseconds >>= 1) {
+        bucket++;
+    }
+    counts[bucket]++;
+    total++;
+    sum += nanoseconds;
+    longest = max(longest, nanoseconds);
+}
+
+/*
+ * @param double q between 0 and 1
+ * @return long upper bound (nanoseconds) of the bucket holding the q quantile,
+ * never above the longest duration
+ */
+long DurationHistogram::quantile(double q) const {
+    long seen = 0;
+    for (int bucket = 0; bucket < BUCKETS; bucket++) {
+        seen += counts[bucket];
+        if (seen > 0 && seen >= q * total) {
+            return min(longest, (1000L << bucket));
+        }
+    }
+    return longest;
+}
+
+/*
+ * Prints the mean, p50, p99 and maximum in milliseconds, then the non-empty buckets
+ * @param ostream& out
+ * @param const string& name of the measure
+ */
+void DurationHistogram::print(ostream& out, const string& name) const {
+    char line[160];
+    snprintf(line, sizeof(line), "  %-16s mean %9.3f ms, p50 <= %9.3f ms, p99 <= %9.3f ms, max %9.3f ms\n",
+             name.c_str(), getMean() / 1e6, quantile(0.5) / 1e6, quantile(0.99) / 1e6, longest / 1e6);
+    out << line << "  " << string(16, ' ');
+    for (int bucket = 0; bucket < BUCKETS; bucket++) {
+        if (counts[bucket] > 0) {
+            out << " " << (bucket == 0 ? 0 : 1L << (bucket - 1)) << "-" << (1L << bucket) << "us:" << counts[bucket];
+        }
+    }
+    out << "\n";
+}
+
+/*
+ * @param double periodMilliseconds wall-clock time of one tick
+ * @throws runtime_error if the period is not positive
+ */
+TickPacer::TickPacer(double periodMilliseconds)
+        : scheduled(0), ticks(0), overruns(0), misses(0), unreported(0) {
+    if (!(periodMilliseconds > 0)) {
+        throw runtime_error("The tick period must be longer than 0 ms");
+    }
+    period = chrono::duration_cast<chrono::steady_clock::duration>(
+            chrono::duration<double, milli>(periodMilliseconds));
+    restart();
+    lastWarning = start - chrono::seconds(1);
+}
+
+/*
+ * Sleeps until the next tick is due (returns at once if it is late)
+ */
+void TickPacer::waitNext() {
+    chrono::steady_clock::time_point due = start + scheduled * period;
+    this_thread::sleep_until(due);
+    woke = chrono::steady_clock::now();
+    latency.add(chrono::duration_cast<chrono::nanoseconds>(woke - due).count());
+}
+
+/*
+ * Records the compute time of the tick started by waitNext() and whether it
+ * met its deadline
+ * @param int tick simulated tick, for the warning
+ */
+void TickPacer::tickDone(int tick) {
+    chrono::steady_clock::time_point done = chrono::steady_clock::now();
+    chrono::steady_clock::time_point deadline = start + (scheduled + 1) * period;
+    chrono::steady_clock::duration took = done - woke;
+    compute.add(chrono::duration_cast<chrono::nanoseconds>(took).count());
+    scheduled++;
+    ticks++;
+
+    if (took > period) {
+        overruns++;
+    }
+    if (done <= deadline) {
+        return;
+    }
+    misses++;
+    unreported++;
+    if (done - lastWarning >= chrono::seconds(1)) {
+        char line[200];
+        if (took > period) {
+            snprintf(line, sizeof(line), "warning: tick %d took %.3f ms, over its %.3f ms budget", tick,
+                     chrono::duration<double, milli>(took).count(), getPeriodMilliseconds());
+        } else {
+            snprintf(line, sizeof(line), "warning: tick %d finished %.3f ms after its deadline (started late)", tick,
+                     chrono::duration<double, milli>(done - deadline).count());
+        }
+        cerr << line << " (" << unreported << " deadline misses since the last warning)" << endl;
+        lastWarning = done;
+        unreported = 0;
+    }
+}
+
+/*
+ * Starts the schedule again from now (e.g. after a pause: the time the run
+ * was held is not made up for)
+ */
+void TickPacer::restart() {
+    start = chrono::steady_clock::now();
+    scheduled = 0;
+}
+
+/*
+ * Prints the number of ticks, overruns and deadline misses and the latency and compute
+ * time distributions
+ * @param ostream& out
+ */
+void TickPacer::report(ostream& out) const {
+    char line[160];
+    snprintf(line, sizeof(line), "Real time: %ld ticks every %.3f ms, %ld over budget, %ld deadline misses (%.2f%%)\n",
+             ticks, getPeriodMilliseconds(), overruns, misses, ticks > 0 ? 100.0 * misses / ticks : 0);
+    out << line;
+    compute.print(out, "compute time");
+    latency.print(out, "wake-up latency");
+    snprintf(line, sizeof(line), "  longest tick used %.1f%% of the budget, p99 %.1f%%\n",
+             100 * compute.getMax() / 1e6 / getPeriodMilliseconds(),
+             100 * compute.quantile(0.99) / 1e6 / getPeriodMilliseconds());
+    out << line;
+}
+
+#endif
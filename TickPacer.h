@@ -0,0 +1,81 @@
+#ifndef __TICK_PACER_H__
+#define __TICK_PACER_H__
+
+#include <chrono>
+#include <ostream>
+#include <string>
+
+using namespace std;
+
+/*
+ * Durations counted in power-of-two buckets of microseconds (bucket 0 below
+ * 1 us, bucket b from 2^(b-1) to 2^b us), so recording one costs a few
+ * instructions and no allocation however long the run
+ */
+class DurationHistogram {
+    public:
+        static const int BUCKETS = 32;
+
+    private:
+        long counts[BUCKETS];
+        long total;
+        double sum;         // nanoseconds
+        long longest;       // nanoseconds
+
+    public:
+        DurationHistogram();
+
+        void add(long nanoseconds);
+        long quantile(double q) const;
+        void print(ostream& out, const string& name) const;
+
+        inline long getCount() const { return total; }
+        inline long getCount(int bucket) const { return counts[bucket]; }
+        inline double getMean() const { return total > 0 ? sum / total : 0; }
+        inline long getMax() const { return longest; }
+};
+
+/*
+ * Runs ticks on a fixed wall-clock period. Tick k is due at start + k * period
+ * of the monotonic clock and must be done (simulated, drawn, recorded) by the
+ * time tick k + 1 is due; the schedule is absolute, so a late tick doesn't
+ * shift the ones after it (they run back to back until the schedule is met
+ * again). For every tick the pacer records how late it woke up (latency) and
+ * how long it took (compute time), counts the ticks that took longer than the
+ * period (overruns) and those that finished after their deadline, for either
+ * reason (misses), and warns on the error stream about them at most once a
+ * second.
+ */
+class TickPacer {
+    private:
+        chrono::steady_clock::duration period;
+        chrono::steady_clock::time_point start;     // when tick 0 of the schedule is due
+        chrono::steady_clock::time_point woke;      // when the current tick started
+        chrono::steady_clock::time_point lastWarning;
+        long scheduled;                             // ticks since start
+        long ticks;
+        long overruns;
+        long misses;
+        long unreported;                            // misses since the last warning
+        DurationHistogram latency;
+        DurationHistogram compute;
+
+    public:
+        TickPacer(double periodMilliseconds);
+
+        void waitNext();
+        void tickDone(int tick);
+        void restart();
+        void report(ostream& out) const;
+
+        inline double getPeriodMilliseconds() const {
+            return chrono::duration<double, milli>(period).count();
+        }
+        inline long getTicks() const { return ticks; }
+        inline long getOverruns() const { return overruns; }
+        inline long getMisses() const { return misses; }
+        inline const DurationHistogram& getLatency() const { return latency; }
+        inline const DurationHistogram& getCompute() const { return compute; }
+};
+
+#endif
@@ -5,16 +5,33 @@
 
 //Constructor
 Vehicle::Vehicle(VehicleType type, Direction originalDirection, TurnType turnType) :
-    VehicleBase(type, originalDirection), backIndex{-1}, frontIndex{-1}, inTransition{false}, 
+    VehicleBase(type, originalDirection), backIndex{-1}, frontIndex{-1}, speed{0}, spawnTick{-1}, entryTick{-1}, stoppedTicks{0}, inTransition{false}, 
     turnType{turnType}, currDirection{originalDirection} {
         
-    if (type == VehicleType::car) {
-        length = 2;
-    } else if (type == VehicleType::suv) {
-        length = 3;
+    length = lengthOf(type);
+}
+
+//Constructor with an ID assigned by the caller (e.g. a Simulator numbering its own vehicles)
+Vehicle::Vehicle(VehicleType type, Direction originalDirection, TurnType turnType, int id) :
+    VehicleBase(type, originalDirection, id), backIndex{-1}, frontIndex{-1}, speed{0}, spawnTick{-1}, entryTick{-1}, stoppedTicks{0}, inTransition{false}, 
+    turnType{turnType}, currDirection{originalDirection} {
+
+    length = lengthOf(type);
+}
+
+//Constructor for a vehicle class whose length comes from the configuration
+Vehicle::Vehicle(VehicleType type, Direction originalDirection, TurnType turnType, int id, int length) :
+    VehicleBase(type, originalDirection, id), backIndex{-1}, frontIndex{-1}, length{length}, speed{0}, spawnTick{-1}, entryTick{-1}, stoppedTicks{0}, 
+    inTransition{false}, turnType{turnType}, currDirection{originalDirection} {}
+
+//Number of sections occupied by a car, SUV or truck unless the configuration changes it
+int Vehicle::lengthOf(VehicleType type) {
+    if (type == VehicleType::suv) {
+        return 3;
     } else if (type == VehicleType::truck) {
-        length = 4;
+        return 4;
     }
+    return 2;
 }
 
 //Setters
@@ -34,6 +51,18 @@ void Vehicle::setDirection(Direction direction){
     this->currDirection = direction;
 }
 
+void Vehicle::setSpeed(int newSpeed) {
+    this->speed = newSpeed;
+}
+
+void Vehicle::setSpawnTick(int tick) {
+    this->spawnTick = tick;
+}
+
+void Vehicle::setEntryTick(int tick) {
+    this->entryTick = tick;
+}
+
 
 //Copy Constructor
 Vehicle::Vehicle(const Vehicle& other) : VehicleBase(other){ 
@@ -43,6 +72,10 @@ Vehicle::Vehicle(const Vehicle& other) : VehicleBase(other){
     turnType = other.turnType;
     currDirection = other.currDirection;
     length = other.length;
+    speed = other.speed;
+    spawnTick = other.spawnTick;
+    entryTick = other.entryTick;
+    stoppedTicks = other.stoppedTicks;
 }
 
 //Move Constructor
@@ -57,6 +90,10 @@ Vehicle::Vehicle(Vehicle&& other) noexcept : VehicleBase(std::move(other)) {
     turnType = other.turnType;
     currDirection = other.currDirection;
     length = other.length;
+    speed = other.speed;
+    spawnTick = other.spawnTick;
+    entryTick = other.entryTick;
+    stoppedTicks = other.stoppedTicks;
 }
 
 //Copy Assignment
@@ -72,6 +109,11 @@ Vehicle& Vehicle::operator=(const Vehicle& other) {
     inTransition = other.inTransition;
     turnType = other.turnType;
     currDirection = other.currDirection;
+    length = other.length;
+    speed = other.speed;
+    spawnTick = other.spawnTick;
+    entryTick = other.entryTick;
+    stoppedTicks = other.stoppedTicks;
     return *this;
 }
 
@@ -89,6 +131,11 @@ Vehicle& Vehicle::operator=(Vehicle&& other) noexcept {
     inTransition = other.inTransition;
     turnType = other.turnType;
     currDirection = other.currDirection;
+    length = other.length;
+    speed = other.speed;
+    spawnTick = other.spawnTick;
+    entryTick = other.entryTick;
+    stoppedTicks = other.stoppedTicks;
 
     other.vehicleType = VehicleType::car;
     other.vehicleDirection = Direction::north;
@@ -10,29 +10,45 @@ class Vehicle : public VehicleBase {
         int backIndex;
         int frontIndex;
         int length;
+        int speed;          // sections moved during the last tick
+        int spawnTick;      // tick the vehicle arrived (joined its entry queue)
+        int entryTick;      // tick the vehicle entered the intersection
+        int stoppedTicks;   // ticks spent on the road without moving
         bool inTransition;
         TurnType turnType;
         Direction currDirection;
     
     public:
         Vehicle(VehicleType type, Direction originalDirection, TurnType turnType);
+        Vehicle(VehicleType type, Direction originalDirection, TurnType turnType, int id);
+        Vehicle(VehicleType type, Direction originalDirection, TurnType turnType, int id, int length);
         Vehicle(const Vehicle& other);
         Vehicle(Vehicle&& other) noexcept;
         Vehicle& operator=(const Vehicle& other);
         Vehicle& operator=(Vehicle&& other) noexcept;
         ~Vehicle();
 
+        static int lengthOf(VehicleType type);
+
         void setTransition(bool transitionStatus);
         void setBackIndex(int newBackIndex);
         void setFrontIndex(int newFrontIndex);
         void setDirection(Direction direction);
+        void setSpeed(int newSpeed);
+        void setSpawnTick(int tick);
+        void setEntryTick(int tick);
+        inline void addStoppedTick() { stoppedTicks++; }
 
-        inline int getBackIndex() { return backIndex; };
-        inline int getFrontIndex() { return frontIndex; };
-        inline int getLength() { return length; };
-        inline bool getInTransition() { return inTransition; };
-        inline TurnType getTurn() { return turnType; };
-        inline Direction getDirection() { return currDirection; }
+        inline int getBackIndex() const { return backIndex; };
+        inline int getFrontIndex() const { return frontIndex; };
+        inline int getLength() const { return length; };
+        inline int getSpeed() const { return speed; };
+        inline int getSpawnTick() const { return spawnTick; };
+        inline int getEntryTick() const { return entryTick; };
+        inline int getStoppedTicks() const { return stoppedTicks; };
+        inline bool getInTransition() const { return inTransition; };
+        inline TurnType getTurn() const { return turnType; };
+        inline Direction getDirection() const { return currDirection; }
 };
 
 #endif
\ No newline at end of file
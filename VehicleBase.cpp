@@ -11,6 +11,12 @@ VehicleBase::VehicleBase(VehicleType type, Direction direction)
       vehicleDirection(direction)
 {}
 
+VehicleBase::VehicleBase(VehicleType type, Direction direction, int id)
+    : vehicleID(id),
+      vehicleType(type),
+      vehicleDirection(direction)
+{}
+
 VehicleBase::VehicleBase(const VehicleBase& other)
     : vehicleID(other.vehicleID),
       vehicleType(other.vehicleType),
@@ -18,6 +18,7 @@ class VehicleBase
 
    public:
       VehicleBase(VehicleType type, Direction originalDirection);
+      VehicleBase(VehicleType type, Direction originalDirection, int id);
       VehicleBase(const VehicleBase& other);
       VehicleBase(VehicleBase&& other) noexcept;
       VehicleBase& operator=(const VehicleBase& other);
@@ -0,0 +1,119 @@
+#ifndef __WHAT_IF_BRANCHES_CPP__
+#define __WHAT_IF_BRANCHES_CPP__
+
+#include "WhatIfBranches.h"
+
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace std;
+
+/*
+ * Runs every plan from the current state of the simulator, at most processes
+ * branches at a time
+ * @param Simulator& sim running simulation (left unchanged)
+ * @param const vector<SimConfig>& plans configurations of the branches, which
+ * may differ from the one of sim only in the light durations (their
+ * maximum_simulated_time is replaced by the end of the horizon)
+ * @param int horizon ticks simulated by every branch
+ * @param int processes branches run at the same time (at least 1)
+ * @return vector<RunStatistics> totals of every branch over the horizon, in plan order
+ * @throws runtime_error if a branch can't be started or fails
+ */
+vector<RunStatistics> WhatIfBranches::run(Simulator& sim, const vector<SimConfig>& plans, int horizon,
+                                          int processes) {
+    if (processes < 1 || horizon < 0) {
+        throw runtime_error("A branch needs at least one process and a horizon of at least 0 ticks");
+    }
+    if (plans.empty()) {
+        return {};
+    }
+    size_t bytes = plans.size() * sizeof(Slot);
+    void* memory = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED) {
+        throw runtime_error("Unable to map shared memory for the branches");
+    }
+    Slot* slots = static_cast<Slot*>(memory);
+
+    // buffered output would otherwise be written again by every branch
+    cout.flush();
+    cerr.flush();
+
+    string failure;
+    for (size_t first = 0; first < plans.size() && failure.empty(); first += processes) {
+        size_t last = min(plans.size(), first + processes);
+        vector<pid_t> branches;
+        for (size_t b = first; b < last; b++) {
+            slots[b].failed = 0;
+            pid_t pid = fork();
+            if (pid < 0) {
+                failure = "Unable to start a branch process";
+                break;
+            }
+            if (pid == 0) {
+                runBranch(sim, plans[b], horizon, slots[b]);
+            }
+            branches.push_back(pid);
+        }
+
+        // the branches of a wave have the same horizon, so they finish together
+        for (size_t k = 0; k < branches.size(); k++) {
+            int status = 0;
+            waitpid(branches[k], &status, 0);
+            Slot& slot = slots[first + k];
+            if (failure.empty() && slot.failed) {
+                failure = "Branch " + to_string(first + k) + " failed: " + slot.message;
+            } else if (failure.empty() && !(WIFEXITED(status) && WEXITSTATUS(status) == 0)) {
+                failure = "Branch " + to_string(first + k) + " failed";
+            }
+        }
+    }
+
+    vector<RunStatistics> results;
+    for (size_t b = 0; b < plans.size() && failure.empty(); b++) {
+        results.push_back(slots[b].statistics);
+    }
+    munmap(memory, bytes);
+    if (!failure.empty()) {
+        throw runtime_error(failure);
+    }
+    return results;
+}
+
+/*
+ * Branch process: runs one plan on its copy of the simulator and never returns
+ * @param Simulator& sim copy-on-write copy of the running simulation
+ * @param const SimConfig& plan
+ * @param int horizon
+ * @param Slot& slot receives the totals of the horizon
+ */
+void WhatIfBranches::runBranch(Simulator& sim, const SimConfig& plan, int horizon, Slot& slot) {
+    try {
+        // the writer thread was not copied by fork(): records of the branch are
+        // not kept, and the writer is never destroyed (the process ends with _exit)
+        static shared_ptr<LifetimeWriter> parkedWriter;
+        parkedWriter = sim.getLifetimeWriter();
+        sim.setLifetimeWriter(nullptr);
+
+        map<string, double> parameters = plan.getParameters();
+        parameters["maximum_simulated_time"] = sim.getTime() + horizon;
+        sim.retime(SimConfig::fromParameters(parameters));
+
+        RunStatistics start = sim.getStatistics();
+        sim.step(horizon);
+        slot.statistics = sim.getStatistics().since(start);
+    } catch (const exception& e) {
+        strncpy(slot.message, e.what(), MESSAGE_BYTES - 1);
+        slot.message[MESSAGE_BYTES - 1] = '\0';
+        slot.failed = 1;
+        _exit(1);
+    }
+    _exit(0);
+}
+
+#endif
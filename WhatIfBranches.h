@@ -0,0 +1,39 @@
+#ifndef __WHAT_IF_BRANCHES_H__
+#define __WHAT_IF_BRANCHES_H__
+
+#include <vector>
+#include "Simulator.h"
+#include "SimConfig.h"
+#include "RunStatistics.h"
+
+using namespace std;
+
+/*
+ * What-if branches of a running simulation. Every branch is a fork() of the
+ * calling process, so it starts from the exact state of the simulator,
+ * vehicles, queues and random streams included, without copying anything up
+ * front: the kernel only copies the memory pages a branch writes to. A branch
+ * switches to its own light durations (Simulator::retime, at the end of the
+ * running cycle), runs for the horizon and hands the totals of the horizon
+ * back through memory shared with the caller. The simulator of the caller is
+ * left as it was. With paired_random_streams the branches see the same
+ * arrivals, so their differences come from the lights alone.
+ */
+class WhatIfBranches {
+    private:
+        static const int MESSAGE_BYTES = 256;
+
+        // Result of one branch, in memory shared with the branch process
+        struct Slot {
+            RunStatistics statistics;
+            int failed;
+            char message[MESSAGE_BYTES];    // what went wrong in the branch
+        };
+
+        static void runBranch(Simulator& sim, const SimConfig& plan, int horizon, Slot& slot);
+
+    public:
+        static vector<RunStatistics> run(Simulator& sim, const vector<SimConfig>& plans, int horizon, int processes);
+};
+
+#endif
@@ -0,0 +1,93 @@
+#include "Simulator.h"
+#include "WhatIfBranches.h"
+
+#include <cstdio>
+#include <stdexcept>
+#include <thread>
+
+using namespace std;
+
+// Light durations of a plan, in the order given on the command line
+static const int TIMINGS = 4;
+static const char* TIMING_NAMES[TIMINGS] = {"green_north_south", "yellow_north_south",
+                                            "green_east_west", "yellow_east_west"};
+
+static void printUsage() {
+    cerr << "Usage: ./WhatIfTimings [config_file] [seed] [tick] [horizon] [options]" << endl;
+    cerr << "Runs the configuration up to tick, then branches from that state and compares" << endl;
+    cerr << "light plans over the next horizon ticks (the first branch keeps the current plan)" << endl;
+    cerr << "  --plan GNS YNS GEW YEW  green and yellow durations of a branch (repeatable)" << endl;
+    cerr << "  --processes P           branches run at the same time (default: all cores)" << endl;
+}
+
+int main(int argc, char* argv[]) {
+
+    if (argc < 5) {
+        printUsage();
+        exit(0);
+    }
+
+    try {
+        SimConfig config = SimConfig::fromFile(argv[1]);
+        int seed = stoi(argv[2]);
+        int tick = stoi(argv[3]);
+        int horizon = stoi(argv[4]);
+        int processes = max(1u, thread::hardware_concurrency());
+
+        // the current plan first, as the reference of the differences
+        vector<SimConfig> plans = {config};
+        vector<string> names = {"current"};
+        for (int a = 5; a < argc; a++) {
+            string option = argv[a];
+            if (option == "--plan" && a + TIMINGS < argc) {
+                map<string, double> parameters = config.getParameters();
+                string name;
+                for (int i = 0; i < TIMINGS; i++) {
+                    parameters[TIMING_NAMES[i]] = stoi(argv[++a]);
+                    name += (i > 0 ? "/" : "") + string(argv[a]);
+                }
+                plans.push_back(SimConfig::fromParameters(parameters));
+                names.push_back(name);
+            } else if (option == "--processes" && a + 1 < argc) {
+                processes = stoi(argv[++a]);
+            } else {
+                throw runtime_error("Unknown or incomplete option: " + option);
+            }
+        }
+        if (tick < 0 || horizon < 1) {
+            throw runtime_error("tick must not be negative and horizon must be at least 1");
+        }
+
+        // the run up to the branching point must not stop early
+        map<string, double> parameters = config.getParameters();
+        parameters["maximum_simulated_time"] = max(config.simTime, tick);
+        Simulator sim(SimConfig::fromParameters(parameters), seed);
+        sim.step(tick);
+
+        vector<RunStatistics> results = WhatIfBranches::run(sim, plans, horizon, processes);
+
+        cout << plans.size() << " branches from tick " << tick << " over " << horizon << " ticks";
+        cout << " (durations green/yellow north-south, green/yellow east-west)" << endl;
+        printf("  %-16s", "plan");
+        for (int k = 0; k < KPI_COUNT; k++) {
+            printf(" %24s", RunStatistics::kpiLabel(static_cast<Kpi>(k)).c_str());
+        }
+        printf("\n");
+        for (size_t b = 0; b < plans.size(); b++) {
+            printf("  %-16s", names[b].c_str());
+            for (int k = 0; k < KPI_COUNT; k++) {
+                Kpi kpi = static_cast<Kpi>(k);
+                double value = results[b].getKpi(kpi);
+                if (b == 0) {
+                    printf(" %24.4f", value);
+                } else {
+                    printf(" %12.4f (%+9.4f)", value, value - results[0].getKpi(kpi));
+                }
+            }
+            printf("\n");
+        }
+    } catch (const exception& e) {
+        cerr << e.what() << endl;
+        return 2;
+    }
+}